@@ -0,0 +1,76 @@
+// AssetLoader.cpp
+
+#include "AssetLoader.h"
+#include <pthread.h>
+#include <signal.h>
+#include <iostream>
+
+AssetLoader::AssetLoader() : started(std::chrono::steady_clock::now()) {}
+
+template <typename T>
+std::future<T> AssetLoader::launch(std::function<T()> fn) {
+    sigset_t mask, oldMask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &mask, &oldMask);
+    std::future<T> result = std::async(std::launch::async, std::move(fn));
+    pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+    return result;
+}
+
+void AssetLoader::decoded(std::chrono::steady_clock::time_point begin) {
+    auto now = std::chrono::steady_clock::now();
+    decodeWorkNs += std::chrono::duration_cast<std::chrono::nanoseconds>(now - begin).count();
+    long long done = std::chrono::duration_cast<std::chrono::nanoseconds>(now - started).count();
+    long long last = lastDecodedNs.load();
+    while (done > last && !lastDecodedNs.compare_exchange_weak(last, done)) {
+    }
+}
+
+void AssetLoader::loadTexture(const std::string &path, sf::Texture &target) {
+    std::function<std::unique_ptr<sf::Image>()> decode = [this, path]() {
+        auto begin = std::chrono::steady_clock::now();
+        std::unique_ptr<sf::Image> image(new sf::Image());
+        if (!image->loadFromFile(path)) image.reset();
+        decoded(begin);
+        return image;
+    };
+    textures.push_back({path, &target, launch(decode)});
+}
+
+void AssetLoader::loadFont(const std::string &path, sf::Font &target) {
+    std::function<bool()> load = [this, path, &target]() {
+        auto begin = std::chrono::steady_clock::now();
+        bool loaded = target.loadFromFile(path);
+        decoded(begin);
+        return loaded;
+    };
+    fonts.push_back({path, launch(load)});
+}
+
+bool AssetLoader::finish() {
+    bool ok = true;
+    for (auto &pending : fonts) {
+        if (!pending.loaded.get()) {
+            std::cerr << "Failed to load font '" << pending.path << "'!" << std::endl;
+            ok = false;
+        }
+    }
+    std::vector<std::unique_ptr<sf::Image>> images;
+    for (auto &pending : textures) {
+        images.push_back(pending.image.get());
+    }
+    auto uploadStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < textures.size(); ++i) {
+        if (!images[i] || !textures[i].target->loadFromImage(*images[i])) {
+            std::cerr << "Failed to load texture '" << textures[i].path << "'!" << std::endl;
+            ok = false;
+        }
+    }
+    uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+    textures.clear();
+    fonts.clear();
+    return ok;
+}
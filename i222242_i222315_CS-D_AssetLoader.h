@@ -0,0 +1,60 @@
+// AssetLoader.h
+
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Decodes images and fonts on worker threads while the rest of startup runs.
+// Only the decoding happens there: textures are uploaded by finish(), which is
+// called on the render thread once everything else is set up.
+class AssetLoader {
+private:
+    struct PendingTexture {
+        std::string path;
+        sf::Texture *target;
+        std::future<std::unique_ptr<sf::Image>> image; // null if decoding failed
+    };
+    struct PendingFont {
+        std::string path;
+        std::future<bool> loaded;
+    };
+
+    std::vector<PendingTexture> textures;
+    std::vector<PendingFont> fonts;
+    std::chrono::steady_clock::time_point started;
+    std::atomic<long long> lastDecodedNs{0}; // since `started`, when the last worker finished
+    std::atomic<long long> decodeWorkNs{0};  // the workers' times added up: the serial cost
+    double uploadMs = 0.0;
+
+    // Records one worker's decode that began at `begin`
+    void decoded(std::chrono::steady_clock::time_point begin);
+
+    // Starts fn on its own thread with SIGINT/SIGTERM/SIGCHLD blocked, so the
+    // workers never take signals meant for the main thread or the supervisor
+    template <typename T>
+    std::future<T> launch(std::function<T()> fn);
+
+public:
+    AssetLoader();
+    void loadTexture(const std::string &path, sf::Texture &target);
+    // The font must stay where it is until finish() returns
+    void loadFont(const std::string &path, sf::Font &target);
+    // Waits for the decoding and uploads the textures. Call on the render thread.
+    // Returns false, after naming each asset that failed, if any did.
+    bool finish();
+    // Wall time from construction until the last asset was decoded
+    double getDecodeMs() const { return lastDecodedNs.load() / 1e6; }
+    // What decoding would have taken one asset after another
+    double getSerialDecodeMs() const { return decodeWorkNs.load() / 1e6; }
+    double getUploadMs() const { return uploadMs; }
+};
+
+#endif // ASSET_LOADER_H
@@ -0,0 +1,46 @@
+// BankerShards.cpp
+
+#include "BankerShards.h"
+
+BankerShards::BankerShards(int shardCount, int resources, int processes) {
+    for (int s = 0; s < shardCount; ++s) {
+        shards.emplace_back(new BankersAlgorithm(resources, processes));
+    }
+}
+
+bool BankerShards::requestOrdered(const ShardRequest *requests, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (requests[i].shard < 0 || requests[i].shard >= size() ||
+            (i > 0 && requests[i].shard <= requests[i - 1].shard)) {
+            orderViolations++;
+            return false;
+        }
+    }
+    if (count > 1) crossRequests++;
+
+    for (int i = 0; i < count; ++i) {
+        if (!shards[requests[i].shard]->requestResources(requests[i].process, requests[i].units)) {
+            // Give back the shards already granted, highest first
+            for (int j = i - 1; j >= 0; --j) {
+                shards[requests[j].shard]->releaseResources(requests[j].process, requests[j].units);
+            }
+            if (i > 0) backouts++;
+            return false;
+        }
+    }
+    return true;
+}
+
+void BankerShards::releaseOrdered(const ShardRequest *requests, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+        shards[requests[i].shard]->releaseResources(requests[i].process, requests[i].units);
+    }
+}
+
+BankerShardStats BankerShards::getStats() const {
+    BankerShardStats stats;
+    stats.crossRequests = crossRequests.load();
+    stats.backouts = backouts.load();
+    stats.orderViolations = orderViolations.load();
+    return stats;
+}
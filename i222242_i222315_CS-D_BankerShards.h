@@ -0,0 +1,47 @@
+// BankerShards.h
+
+#ifndef BANKER_SHARDS_H
+#define BANKER_SHARDS_H
+
+#include "BankersAlgorithm.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// One unit vector asked of one shard, by that shard's process id
+struct ShardRequest {
+    int shard;
+    int process;
+    ResourceVector units;
+};
+
+struct BankerShardStats {
+    long long crossRequests = 0;   // requests spanning more than one shard
+    long long backouts = 0;        // cross requests undone because a later shard refused
+    long long orderViolations = 0; // requests refused for not naming shards in ascending order
+};
+
+// One Banker per intersection (shard), each behind its own lock, so
+// intersections admit vehicles without waiting on each other. A request that
+// spans intersections names its shards in ascending order and is granted shard
+// by shard in that order; if one refuses, the shards already granted are given
+// back. Callers then wait on the shards' semaphores in the same order and
+// release in reverse, so no two requests can each hold what the other needs.
+class BankerShards {
+private:
+    std::vector<std::unique_ptr<BankersAlgorithm>> shards;
+    std::atomic<long long> crossRequests{0};
+    std::atomic<long long> backouts{0};
+    std::atomic<long long> orderViolations{0};
+
+public:
+    BankerShards(int shardCount, int resources, int processes);
+    int size() const { return static_cast<int>(shards.size()); }
+    BankersAlgorithm &shard(int s) { return *shards[s]; }
+    // All or nothing; false if refused or out of order
+    bool requestOrdered(const ShardRequest *requests, int count);
+    void releaseOrdered(const ShardRequest *requests, int count);
+    BankerShardStats getStats() const;
+};
+
+#endif // BANKER_SHARDS_H
@@ -2,64 +2,196 @@
 
 #include "BankersAlgorithm.h"
 #include <algorithm>
+#include <chrono>
 
 BankersAlgorithm::BankersAlgorithm(int resources, int processes)
-    : num_resources(resources), num_processes(processes),
-      total_resources(resources, 0), available(resources, 0),
-      maximum(processes, std::vector<int>(resources, 0)),
-      allocation(processes, std::vector<int>(resources, 0)),
-      need(processes, std::vector<int>(resources, 0)) {}
+    : num_resources(std::min(resources, BANKER_MAX_RESOURCES)) {
+    for (int p = 0; p < processes; ++p) {
+        addRow(ResourceVector());
+    }
+}
+
+int BankersAlgorithm::addRow(const ResourceVector& max_demand) {
+    int process;
+    if (!freeIds.empty()) {
+        process = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        process = static_cast<int>(rowOf.size());
+        rowOf.push_back(NO_BANKER_ROW);
+    }
+    rowOf[process] = static_cast<int>(rows.size());
+    rows.push_back({process, max_demand, ResourceVector(), max_demand});
+    finish.resize(rows.size());
+    safeSequence.reserve(rows.size());
+    candidate.reserve(rows.size());
+    sequenceValid = false;
+    return process;
+}
+
+BankersAlgorithm::Row *BankersAlgorithm::findRow(int process) {
+    if (process < 0 || process >= static_cast<int>(rowOf.size()) || rowOf[process] == NO_BANKER_ROW) {
+        return nullptr;
+    }
+    return &rows[rowOf[process]];
+}
 
 void BankersAlgorithm::setTotalResources(const std::vector<int>& total) {
     std::lock_guard<std::mutex> lock(mtx);
-    total_resources = total;
-    available = total;
+    for (int r = 0; r < num_resources && r < static_cast<int>(total.size()); ++r) {
+        total_resources[r] = total[r];
+        available[r] = total[r];
+    }
+    sequenceValid = false;
 }
 
 void BankersAlgorithm::setMaximum(int process, const std::vector<int>& max_demand) {
     std::lock_guard<std::mutex> lock(mtx);
-    maximum[process] = max_demand;
+    Row *row = findRow(process);
+    if (!row) return;
+    for (int r = 0; r < num_resources && r < static_cast<int>(max_demand.size()); ++r) {
+        row->maximum[r] = max_demand[r];
+    }
     for (int i = 0; i < num_resources; ++i) {
-        need[process][i] = maximum[process][i] - allocation[process][i];
+        row->need[i] = row->maximum[i] - row->allocation[i];
     }
+    sequenceValid = false;
+}
+
+int BankersAlgorithm::registerProcess(const ResourceVector& max_demand) {
+    std::lock_guard<std::mutex> lock(mtx);
+    return addRow(max_demand);
+}
+
+bool BankersAlgorithm::unregisterProcess(int process) {
+    std::lock_guard<std::mutex> lock(mtx);
+    Row *row = findRow(process);
+    if (!row) return false;
+    for (int r = 0; r < num_resources; ++r) {
+        available[r] += row->allocation[r];
+    }
+
+    // Swap the last row into the hole so the table stays dense
+    int hole = rowOf[process];
+    if (hole + 1 != static_cast<int>(rows.size())) {
+        rows[hole] = rows.back();
+        rowOf[rows[hole].process] = hole;
+    }
+    rows.pop_back();
+    finish.pop_back();
+    rowOf[process] = NO_BANKER_ROW;
+    freeIds.push_back(process);
+    // The rest of the sequence still finishes: it only gains what this process held
+    safeSequence.erase(std::remove(safeSequence.begin(), safeSequence.end(), process), safeSequence.end());
+    return true;
+}
+
+int BankersAlgorithm::liveProcesses() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return static_cast<int>(rows.size());
+}
+
+bool BankersAlgorithm::sequenceStillSafe(int requester) {
+    if (!sequenceValid || safeSequence.size() != rows.size()) return false;
+    ResourceVector work = available;
+
+    // A process that finishes only adds to work, so if the requester can finish
+    // now, putting it first never breaks the rest of the sequence
+    const Row &own = rows[rowOf[requester]];
+    bool requesterFirst = true;
+    for (int r = 0; r < num_resources; ++r) {
+        if (own.need[r] > work[r]) requesterFirst = false;
+    }
+    if (requesterFirst) {
+        auto at = std::find(safeSequence.begin(), safeSequence.end(), requester);
+        std::rotate(safeSequence.begin(), at, at + 1);
+    }
+
+    for (int process : safeSequence) {
+        const Row &row = rows[rowOf[process]];
+        for (int r = 0; r < num_resources; ++r) {
+            if (row.need[r] > work[r]) return false;
+        }
+        for (int r = 0; r < num_resources; ++r) {
+            work[r] += row.allocation[r];
+        }
+    }
+    return true;
+}
+
+bool BankersAlgorithm::stateSafe(int requester) {
+    // Reading the clock costs about as much as a cached check, so only a
+    // sample of the checks is timed
+    bool timed = stats.safetyChecks % BANKER_TIMING_SAMPLE == 0;
+    std::chrono::steady_clock::time_point start;
+    if (timed) start = std::chrono::steady_clock::now();
+    bool hit = sequenceStillSafe(requester);
+    bool safe = hit || isSafe();
+    stats.safetyChecks++;
+    if (hit) {
+        stats.cacheHits++;
+    } else {
+        stats.fullChecks++;
+    }
+    if (timed) {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (hit) {
+            cachedCheckNs += ns;
+            cachedTimed++;
+        } else {
+            fullCheckNs += ns;
+            fullTimed++;
+        }
+    }
+    return safe;
 }
 
 bool BankersAlgorithm::isSafe() {
-    std::vector<int> work = available;
-    std::vector<bool> finish(num_processes, false);
+    ResourceVector work = available;
+    std::fill(finish.begin(), finish.end(), 0);
+    candidate.clear();
+    const int live = static_cast<int>(rows.size());
     bool progress = true;
 
     while (progress) {
         progress = false;
-        for (int p = 0; p < num_processes; ++p) {
+        for (int p = 0; p < live; ++p) {
             if (!finish[p]) {
                 bool can_finish = true;
                 for (int r = 0; r < num_resources; ++r) {
-                    if (need[p][r] > work[r]) {
+                    if (rows[p].need[r] > work[r]) {
                         can_finish = false;
                         break;
                     }
                 }
                 if (can_finish) {
                     for (int r = 0; r < num_resources; ++r) {
-                        work[r] += allocation[p][r];
+                        work[r] += rows[p].allocation[r];
                     }
                     finish[p] = true;
+                    candidate.push_back(rows[p].process);
                     progress = true;
                 }
             }
         }
     }
 
-    return std::all_of(finish.begin(), finish.end(), [](bool f) { return f; });
+    if (candidate.size() != rows.size()) {
+        return false; // An unsafe state keeps the old sequence for the rollback
+    }
+    safeSequence.swap(candidate);
+    sequenceValid = true;
+    return true;
 }
 
-bool BankersAlgorithm::requestResources(int process, const std::vector<int>& request) {
+bool BankersAlgorithm::requestResources(int process, const ResourceVector& request) {
     std::lock_guard<std::mutex> lock(mtx);
+    Row *row = findRow(process);
+    if (!row) return false; // Not registered
 
     // Check if request <= need
     for (int r = 0; r < num_resources; ++r) {
-        if (request[r] > need[process][r]) {
+        if (request[r] > row->need[r]) {
             return false; // Exceeds maximum demand
         }
     }
@@ -74,30 +206,39 @@ bool BankersAlgorithm::requestResources(int process, const std::vector<int>& req
     // Try to allocate
     for (int r = 0; r < num_resources; ++r) {
         available[r] -= request[r];
-        allocation[process][r] += request[r];
-        need[process][r] -= request[r];
+        row->allocation[r] += request[r];
+        row->need[r] -= request[r];
     }
 
     // Check if state is safe
-    if (isSafe()) {
+    if (stateSafe(process)) {
         return true; // Allocation successful
     } else {
         // Rollback
         for (int r = 0; r < num_resources; ++r) {
             available[r] += request[r];
-            allocation[process][r] -= request[r];
-            need[process][r] += request[r];
+            row->allocation[r] -= request[r];
+            row->need[r] += request[r];
         }
         return false; // Allocation not safe
     }
 }
 
-void BankersAlgorithm::releaseResources(int process, const std::vector<int>& release) {
+void BankersAlgorithm::releaseResources(int process, const ResourceVector& release) {
     std::lock_guard<std::mutex> lock(mtx);
+    Row *row = findRow(process);
+    if (!row) return;
     for (int r = 0; r < num_resources; ++r) {
-        allocation[process][r] -= release[r];
+        row->allocation[r] -= release[r];
         available[r] += release[r];
-        need[process][r] += release[r];
+        row->need[r] += release[r];
     }
 }
 
+BankerStats BankersAlgorithm::getStats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    BankerStats result = stats;
+    if (cachedTimed > 0) result.meanCachedCheckNs = cachedCheckNs / cachedTimed;
+    if (fullTimed > 0) result.meanFullCheckNs = fullCheckNs / fullTimed;
+    return result;
+}
@@ -3,28 +3,86 @@
 #ifndef BANKERS_ALGORITHM_H
 #define BANKERS_ALGORITHM_H
 
+#include <array>
 #include <vector>
 #include <mutex>
 
+// Resource types a Banker can track. Resource vectors are fixed-size arrays of
+// this length so requests and the safety check never touch the heap.
+static const int BANKER_MAX_RESOURCES = 8;
+typedef std::array<int, BANKER_MAX_RESOURCES> ResourceVector;
+
+static const int NO_BANKER_ROW = -1;
+static const long long BANKER_TIMING_SAMPLE = 64; // one safety check in this many is timed
+
+// A request or release of one unit of a single resource
+inline ResourceVector singleUnit(int resource) {
+    ResourceVector units = {};
+    units[resource] = 1;
+    return units;
+}
+
+struct BankerStats {
+    long long safetyChecks = 0;
+    long long cacheHits = 0;     // checks settled by walking the cached safe sequence
+    long long fullChecks = 0;    // checks that searched for a new sequence
+    double meanCachedCheckNs = 0.0; // over the sampled checks
+    double meanFullCheckNs = 0.0;
+};
+
+// Processes come and go through registerProcess/unregisterProcess. Their rows
+// sit densely in `rows` and `rowOf` maps a process id to its row, so the safety
+// check walks only the live processes. Ids of unregistered processes are reused.
 class BankersAlgorithm {
 private:
+    struct Row {
+        int process;
+        ResourceVector maximum;
+        ResourceVector allocation;
+        ResourceVector need;
+    };
+
     int num_resources;
-    int num_processes;
-    std::vector<int> total_resources;
-    std::vector<int> available;
-    std::vector<std::vector<int>> maximum;
-    std::vector<std::vector<int>> allocation;
-    std::vector<std::vector<int>> need;
+    ResourceVector total_resources = {};
+    ResourceVector available = {};
+    std::vector<Row> rows;
+    std::vector<int> rowOf;   // process id -> row, NO_BANKER_ROW when free
+    std::vector<int> freeIds;
+    std::vector<char> finish; // isSafe() scratch, one per row
     std::mutex mtx; // Mutex for thread safety
 
+    // Last safe sequence found, as process ids. A grant is checked by walking it
+    // once; only when the walk fails is a new sequence searched for. Releases
+    // and unregistering keep it valid; new demands invalidate it.
+    std::vector<int> safeSequence;
+    std::vector<int> candidate; // isSafe() scratch
+    bool sequenceValid = false;
+    BankerStats stats;
+    double cachedCheckNs = 0.0; // summed over the timed checks
+    double fullCheckNs = 0.0;
+    long long cachedTimed = 0;
+    long long fullTimed = 0;
+
+    int addRow(const ResourceVector& max_demand);
+    Row *findRow(int process);
+    bool sequenceStillSafe(int requester);
+    bool stateSafe(int requester);
+
 public:
+    // Registers processes 0 .. processes-1 with no demand; setMaximum gives them one
     BankersAlgorithm(int resources, int processes);
     void setTotalResources(const std::vector<int>& total);
     void setMaximum(int process, const std::vector<int>& max_demand);
-    bool requestResources(int process, const std::vector<int>& request);
-    void releaseResources(int process, const std::vector<int>& release);
+    // Adds a process and returns its id
+    int registerProcess(const ResourceVector& max_demand);
+    // Returns whatever the process still holds and frees its id
+    bool unregisterProcess(int process);
+    int liveProcesses();
+    bool requestResources(int process, const ResourceVector& request);
+    void releaseResources(int process, const ResourceVector& release);
+    // Searches for a safe sequence from scratch and caches it
     bool isSafe();
+    BankerStats getStats();
 };
 
 #endif // BANKERS_ALGORITHM_H
-
@@ -0,0 +1,89 @@
+// ChallanGenerator.cpp
+// Challan worker, spawned by the simulation once per shard: smarttraffix-challan SHARD
+
+#include "common.h"
+#include <fcntl.h>
+#include <mqueue.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+
+// Each worker owns one shard: it reads only its shard queue and keeps the
+// activeChallans ledger for the plates hashing to it, so a plate's events stay ordered.
+// The simulation forwards settled payments to the same queue to close challans.
+int main(int argc, char *argv[]) {
+    installChildSignalHandlers();
+    int shard = argc > 1 ? std::atoi(argv[1]) : 0;
+    std::string tag = "[ChallanGenerator " + std::to_string(shard) + "] ";
+    std::map<std::string, bool> activeChallans; // vehicleID -> challanActive
+    unsigned long updatesDropped = 0; // challan updates the portal was not there to read
+
+    // Open the message queue to receive speed violations
+    mqd_t mqSmartToChallanLocal = mq_open(challanShardQueueName(shard).c_str(), O_RDONLY);
+    if (mqSmartToChallanLocal == (mqd_t)-1) {
+        std::cerr << tag << "Failed to open " << challanShardQueueName(shard) << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // Open the message queue to send challan updates. Only the portal reads it, and only
+    // while a user is at the menu, so the send must never block issuance.
+    mqd_t mqChallanToSmartLocal = mq_open(MQ_CHALLAN_TO_SMART, O_WRONLY | O_NONBLOCK);
+    if (mqChallanToSmartLocal == (mqd_t)-1) {
+        std::cerr << tag << "Failed to open MQ_CHALLAN_TO_SMART: " << strerror(errno) << std::endl;
+        mq_close(mqSmartToChallanLocal);
+        return 1;
+    }
+
+    while (childRunning) {
+        char buffer[MQ_MAX_SIZE]; // mq_receive needs room for the queue's full message size
+        ssize_t bytesRead = mq_receive(mqSmartToChallanLocal, buffer, sizeof(buffer), NULL);
+        if (bytesRead == static_cast<ssize_t>(sizeof(PaymentMsg))) {
+            PaymentMsg *payment = reinterpret_cast<PaymentMsg*>(buffer);
+            std::string vehicleID(payment->vehicleID);
+            auto challan = activeChallans.find(vehicleID);
+            if (payment->paid && challan != activeChallans.end() && challan->second) {
+                challan->second = false;
+                std::cout << tag << "Challan for Vehicle " << vehicleID << " settled." << std::endl;
+            }
+        } else if (bytesRead >= 0) {
+            ViolationMsg *msg = reinterpret_cast<ViolationMsg*>(buffer);
+            std::string vehicleID(msg->vehicleID);
+
+            // Check if vehicle already has an active challan
+            auto challan = activeChallans.find(vehicleID);
+            if (challan == activeChallans.end() || !challan->second) {
+                // Create a challan update message
+                ChallanUpdateMsg challanMsg;
+                std::strncpy(challanMsg.vehicleID, vehicleID.c_str(), sizeof(challanMsg.vehicleID) - 1);
+                challanMsg.vehicleID[sizeof(challanMsg.vehicleID) - 1] = '\0';
+                challanMsg.paid = false;
+
+                // The challan stands whether or not the portal hears of it; a full
+                // queue only drops the notification
+                activeChallans[vehicleID] = true;
+                std::cout << tag << "Issued " << violationTypeName(msg->violationType)
+                          << " challan to Vehicle " << vehicleID;
+                if (mq_send(mqChallanToSmartLocal, reinterpret_cast<const char*>(&challanMsg), sizeof(challanMsg), 0) == -1) {
+                    if (errno == EAGAIN) {
+                        std::cout << " (portal queue full, " << ++updatesDropped << " updates dropped)";
+                    } else if (errno != EINTR) {
+                        std::cerr << tag << "Failed to send challan update: " << strerror(errno) << std::endl;
+                    }
+                }
+                std::cout << std::endl;
+            } else {
+                std::cout << tag << "Vehicle " << vehicleID << " already has an active challan." << std::endl;
+            }
+        } else if (errno != EINTR) {
+            std::cerr << tag << "Failed to receive message: " << strerror(errno) << std::endl;
+        }
+    }
+
+    // Close message queues
+    mq_close(mqSmartToChallanLocal);
+    mq_close(mqChallanToSmartLocal);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Collision.cpp
+
+#include "Collision.h"
+#include <algorithm>
+#include <limits>
+
+// Interval of the step during which [aMin, aMax] moving at `velocity` overlaps [bMin, bMax]
+static bool axisOverlap(float aMin, float aMax, float bMin, float bMax, float velocity, float &enter, float &exit) {
+    if (velocity == 0.f) {
+        if (aMax <= bMin || bMax <= aMin) return false;
+        enter = -std::numeric_limits<float>::infinity();
+        exit = std::numeric_limits<float>::infinity();
+        return true;
+    }
+    float t1 = (bMin - aMax) / velocity;
+    float t2 = (bMax - aMin) / velocity;
+    enter = std::min(t1, t2);
+    exit = std::max(t1, t2);
+    return true;
+}
+
+float sweptBoxContact(const SweptBox &a, const SweptBox &b) {
+    // Motion of a relative to b, with b held still
+    float vx = a.dx - b.dx, vy = a.dy - b.dy;
+    float enterX, exitX, enterY, exitY;
+    if (!axisOverlap(a.minX, a.maxX, b.minX, b.maxX, vx, enterX, exitX)) return -1.f;
+    if (!axisOverlap(a.minY, a.maxY, b.minY, b.maxY, vy, enterY, exitY)) return -1.f;
+
+    float enter = std::max(enterX, enterY);
+    float exit = std::min(exitX, exitY);
+    // Meeting exactly at the end of the step is only edge contact
+    if (enter >= exit || enter >= 1.f || exit <= 0.f) return -1.f;
+    return std::max(enter, 0.f);
+}
+
+size_t findSweptCollisions(const std::vector<SweptBox> &boxes, std::vector<CollisionPair> &pairs,
+                           std::pmr::memory_resource *scratch) {
+    pairs.clear();
+
+    // Bounds of each box over its whole step
+    struct Sweep {
+        float minX, minY, maxX, maxY;
+        size_t box;
+    };
+    std::pmr::vector<Sweep> sweeps(scratch);
+    sweeps.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        const SweptBox &b = boxes[i];
+        sweeps.push_back({std::min(b.minX, b.minX + b.dx), std::min(b.minY, b.minY + b.dy),
+                          std::max(b.maxX, b.maxX + b.dx), std::max(b.maxY, b.maxY + b.dy), i});
+    }
+    std::sort(sweeps.begin(), sweeps.end(), [](const Sweep &p, const Sweep &q) { return p.minX < q.minX; });
+
+    // Sweep along x keeping the boxes whose x range is still open
+    size_t candidates = 0;
+    std::pmr::vector<size_t> active(scratch);
+    for (size_t i = 0; i < sweeps.size(); ++i) {
+        const Sweep &s = sweeps[i];
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [&](size_t k) { return sweeps[k].maxX <= s.minX; }),
+                     active.end());
+        for (size_t k : active) {
+            const Sweep &o = sweeps[k];
+            if (o.maxY <= s.minY || s.maxY <= o.minY) continue;
+            candidates++;
+            float time = sweptBoxContact(boxes[s.box], boxes[o.box]);
+            if (time >= 0.f) {
+                pairs.push_back({std::min(s.box, o.box), std::max(s.box, o.box), time});
+            }
+        }
+        active.push_back(i);
+    }
+
+    std::sort(pairs.begin(), pairs.end(), [](const CollisionPair &p, const CollisionPair &q) { return p.time < q.time; });
+    return candidates;
+}
@@ -0,0 +1,35 @@
+// Collision.h
+
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Axis-aligned box at the start of a step, moving by (dx, dy) over the step
+struct SweptBox {
+    float minX, minY, maxX, maxY;
+    float dx, dy;
+};
+
+// Two boxes that touch during the step, `time` into it (0..1)
+struct CollisionPair {
+    size_t a, b;
+    float time;
+};
+
+// Earliest fraction of the step at which the two moving boxes overlap, or -1 if they
+// stay apart. Boxes that already overlap at the start of the step collide at 0;
+// boxes that only touch edges do not collide.
+float sweptBoxContact(const SweptBox &a, const SweptBox &b);
+
+// Continuous collision detection over one step. A sort-and-sweep broadphase on the
+// bounds of each box's whole motion finds candidate pairs, which then get the exact
+// swept test, so fast boxes cannot step through each other however long the step.
+// Pairs come out earliest first. Returns the number of candidate pairs tested.
+// The broadphase's working lists come from `scratch`.
+size_t findSweptCollisions(const std::vector<SweptBox> &boxes, std::vector<CollisionPair> &pairs,
+                           std::pmr::memory_resource *scratch = std::pmr::get_default_resource());
+
+#endif // COLLISION_H
@@ -0,0 +1,238 @@
+// DeadlockBench.cpp
+
+#include "DeadlockBench.h"
+#include "BankersAlgorithm.h"
+#include <semaphore.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static const int BENCH_RESOURCES = 2;        // a lane and the active vehicles, as in the simulation
+static const int DEADLOCK_TIMEOUT_MS = 100;  // a wait this long is taken as a deadlock
+static const double STARVATION_MS = 20.0;    // an acquire waiting this long counts as starved
+static const int HOLD_SPINS = 200;           // work done while holding the resources
+static const int MAX_BACKOFF_US = 1000;
+
+// Resources one operation takes, in the order it asks for them
+struct BenchOp {
+    int count;
+    int order[BENCH_RESOURCES];
+};
+
+struct BenchResources {
+    sem_t sems[BENCH_RESOURCES];
+    std::atomic<long long> deadlocks{0};
+    std::atomic<long long> retries{0}; // refusals and failed try-locks
+};
+
+// Waits on one semaphore; false once DEADLOCK_TIMEOUT_MS has passed
+static bool timedWait(sem_t *sem) {
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += DEADLOCK_TIMEOUT_MS * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    while (sem_timedwait(sem, &deadline) == -1) {
+        if (errno == ETIMEDOUT) return false;
+        if (errno != EINTR) {
+            perror("sem_timedwait");
+            return false;
+        }
+    }
+    return true;
+}
+
+static void postAll(BenchResources &res, const int *order, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+        sem_post(&res.sems[order[i]]);
+    }
+}
+
+// Waits for each resource in turn. A wait that times out is a deadlock: what is
+// held is given back so the run can go on, and the whole set is tried again.
+static void waitInOrder(BenchResources &res, const int *order, int count) {
+    for (;;) {
+        int held = 0;
+        while (held < count && timedWait(&res.sems[order[held]])) {
+            held++;
+        }
+        if (held == count) return;
+        res.deadlocks++;
+        postAll(res, order, held);
+        std::this_thread::yield();
+    }
+}
+
+class DeadlockStrategy {
+public:
+    virtual ~DeadlockStrategy() {}
+    virtual const char *name() const = 0;
+    // Returns once every resource of the op is held
+    virtual void acquire(int worker, const BenchOp &op, BenchResources &res) = 0;
+    virtual void release(int, const BenchOp &op, BenchResources &res) {
+        postAll(res, op.order, op.count);
+    }
+};
+
+// Waits in whatever order the op asks: two ops asking in opposite orders can deadlock
+class NoProtection : public DeadlockStrategy {
+public:
+    const char *name() const override { return "no protection "; }
+    void acquire(int, const BenchOp &op, BenchResources &res) override {
+        waitInOrder(res, op.order, op.count);
+    }
+};
+
+// Every op takes resources in ascending index order, so no wait cycle can form
+class GlobalOrdering : public DeadlockStrategy {
+public:
+    const char *name() const override { return "lock ordering "; }
+    void acquire(int, const BenchOp &op, BenchResources &res) override {
+        static_assert(BENCH_RESOURCES == 2, "ordering below assumes at most two resources");
+        int sorted[BENCH_RESOURCES] = {op.order[0], op.order[1]};
+        if (op.count == 2 && sorted[1] < sorted[0]) std::swap(sorted[0], sorted[1]);
+        waitInOrder(res, sorted, op.count);
+    }
+};
+
+// Never blocks while holding: on a busy resource, gives back what it holds and
+// retries after an exponentially growing, jittered pause
+class TryLockBackoff : public DeadlockStrategy {
+public:
+    const char *name() const override { return "try-lock      "; }
+    void acquire(int worker, const BenchOp &op, BenchResources &res) override {
+        static thread_local std::minstd_rand jitter(worker + 1);
+        int backoffUs = 1;
+        for (;;) {
+            int held = 0;
+            while (held < op.count && sem_trywait(&res.sems[op.order[held]]) == 0) {
+                held++;
+            }
+            if (held == op.count) return;
+            res.retries++;
+            postAll(res, op.order, held);
+            std::this_thread::sleep_for(std::chrono::microseconds(1 + jitter() % backoffUs));
+            backoffUs = std::min(backoffUs * 2, MAX_BACKOFF_US);
+        }
+    }
+};
+
+// The simulation's scheme: each unit is granted by the Banker before its
+// semaphore is waited on, and an unsafe or unavailable grant is retried
+class BankerAvoidance : public DeadlockStrategy {
+private:
+    BankersAlgorithm banker;
+
+public:
+    explicit BankerAvoidance(int workers) : banker(BENCH_RESOURCES, workers) {
+        banker.setTotalResources(std::vector<int>(BENCH_RESOURCES, 1));
+        for (int w = 0; w < workers; ++w) {
+            banker.setMaximum(w, std::vector<int>(BENCH_RESOURCES, 1));
+        }
+    }
+    const char *name() const override { return "banker        "; }
+    void acquire(int worker, const BenchOp &op, BenchResources &res) override {
+        for (int i = 0; i < op.count; ++i) {
+            ResourceVector units = singleUnit(op.order[i]);
+            while (!banker.requestResources(worker, units)) {
+                res.retries++;
+                std::this_thread::yield();
+            }
+            waitInOrder(res, &op.order[i], 1);
+        }
+    }
+    void release(int worker, const BenchOp &op, BenchResources &res) override {
+        for (int i = op.count - 1; i >= 0; --i) {
+            sem_post(&res.sems[op.order[i]]);
+            banker.releaseResources(worker, singleUnit(op.order[i]));
+        }
+    }
+};
+
+static double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+}
+
+static void runStrategy(DeadlockStrategy &strategy, int workers, long long opsPerWorker) {
+    BenchResources res;
+    for (auto &sem : res.sems) {
+        sem_init(&sem, 0, 1);
+    }
+    std::vector<std::vector<double>> latencies(workers);
+    std::atomic<long long> starved{0};
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; ++w) {
+        threads.emplace_back([&, w] {
+            std::mt19937 gen(w + 1);
+            std::vector<double> &mine = latencies[w];
+            mine.reserve(opsPerWorker);
+            for (long long i = 0; i < opsPerWorker; ++i) {
+                // Half the ops take one resource, half take both in either order
+                BenchOp op;
+                switch (gen() % 4) {
+                    case 0: op = {1, {0, 0}}; break;
+                    case 1: op = {1, {1, 0}}; break;
+                    case 2: op = {2, {0, 1}}; break;
+                    default: op = {2, {1, 0}}; break;
+                }
+                auto t0 = std::chrono::steady_clock::now();
+                strategy.acquire(w, op, res);
+                double waited = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+                volatile int work = 0;
+                for (int s = 0; s < HOLD_SPINS; ++s) {
+                    work = work + 1;
+                }
+                strategy.release(w, op, res);
+                mine.push_back(waited);
+                if (waited > STARVATION_MS * 1000.0) starved++;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (auto &mine : latencies) {
+        all.insert(all.end(), mine.begin(), mine.end());
+    }
+    std::sort(all.begin(), all.end());
+    std::cout << "[DeadlockBench] " << strategy.name() << ": " << static_cast<long long>(all.size() / seconds)
+              << " ops/s, acquire p50 " << percentile(all, 0.5) << " us, p99 " << percentile(all, 0.99)
+              << " us, p99.9 " << percentile(all, 0.999) << " us, max " << (all.empty() ? 0.0 : all.back())
+              << " us, " << res.deadlocks.load() << " deadlocks, " << starved.load() << " starved, "
+              << res.retries.load() << " retries" << std::endl;
+
+    for (auto &sem : res.sems) {
+        sem_destroy(&sem);
+    }
+}
+
+int runDeadlockBenchmark(int workers, long long opsPerWorker) {
+    std::cout << "[DeadlockBench] " << workers << " workers, " << opsPerWorker << " ops each; a wait over "
+              << DEADLOCK_TIMEOUT_MS << " ms is a deadlock, an acquire over " << STARVATION_MS
+              << " ms is starved" << std::endl;
+    std::unique_ptr<DeadlockStrategy> strategies[] = {
+        std::unique_ptr<DeadlockStrategy>(new BankerAvoidance(workers)),
+        std::unique_ptr<DeadlockStrategy>(new GlobalOrdering()),
+        std::unique_ptr<DeadlockStrategy>(new TryLockBackoff()),
+        std::unique_ptr<DeadlockStrategy>(new NoProtection()),
+    };
+    for (auto &strategy : strategies) {
+        runStrategy(*strategy, workers, opsPerWorker);
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+// DeadlockBench.h
+
+#ifndef DEADLOCK_BENCH_H
+#define DEADLOCK_BENCH_H
+
+// Runs one headless workload under each way of handling deadlock and prints
+// throughput, acquire latency percentiles and deadlock/starvation counts per
+// strategy. Workers repeatedly take a lane semaphore, the active-vehicles
+// semaphore or both, in either order, as the simulation's processes do.
+int runDeadlockBenchmark(int workers, long long opsPerWorker);
+
+#endif // DEADLOCK_BENCH_H
@@ -0,0 +1,73 @@
+// DriverBehavior.cpp
+
+#include "DriverBehavior.h"
+#include <algorithm>
+#include <cmath>
+
+// Cautious drivers keep under the limit, normal drivers sit just below it and
+// aggressive drivers run over it with wider swings
+static const DriverProfileParams profileTable[NUM_DRIVER_PROFILES] = {
+    {"Cautious", 0.25f, 0.85f, 0.5f, 2.0f},
+    {"Normal", 0.55f, 0.95f, 0.5f, 4.0f},
+    {"Aggressive", 0.20f, 1.10f, 0.4f, 6.0f},
+};
+
+const DriverProfileParams &driverProfileParams(DriverProfile profile) {
+    return profileTable[profile];
+}
+
+DriverProfile sampleDriverProfile(std::mt19937 &gen) {
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    float u = dist(gen);
+    for (int p = 0; p < NUM_DRIVER_PROFILES - 1; ++p) {
+        if (u < profileTable[p].share) return static_cast<DriverProfile>(p);
+        u -= profileTable[p].share;
+    }
+    return static_cast<DriverProfile>(NUM_DRIVER_PROFILES - 1);
+}
+
+float sampleInitialSpeed(DriverProfile profile, float speedLimit, std::mt19937 &gen) {
+    const DriverProfileParams &params = profileTable[profile];
+    // Stationary standard deviation of the process is volatility / sqrt(2 * reversion)
+    std::normal_distribution<float> dist(params.desiredRatio * speedLimit,
+                                         params.volatility / std::sqrt(2.f * params.reversion));
+    return std::max(0.f, dist(gen));
+}
+
+void SpeedProcessBatch::clear() {
+    speed.clear(); desired.clear(); reversion.clear(); volatility.clear(); noise.clear();
+}
+
+void SpeedProcessBatch::reserve(size_t n) {
+    speed.reserve(n); desired.reserve(n); reversion.reserve(n); volatility.reserve(n); noise.reserve(n);
+}
+
+void SpeedProcessBatch::add(float currentSpeed, DriverProfile profile, float speedLimit) {
+    const DriverProfileParams &params = profileTable[profile];
+    speed.push_back(currentSpeed);
+    desired.push_back(params.desiredRatio * speedLimit);
+    reversion.push_back(params.reversion);
+    volatility.push_back(params.volatility);
+}
+
+void updateSpeedProcesses(SpeedProcessBatch &batch, float dt, std::mt19937 &gen) {
+    const size_t n = batch.size();
+    batch.noise.resize(n);
+
+    std::normal_distribution<float> standardNormal(0.f, 1.f);
+    float *z = batch.noise.data();
+    for (size_t i = 0; i < n; ++i) {
+        z[i] = standardNormal(gen);
+    }
+
+    // Euler-Maruyama step of dv = reversion * (desired - v) dt + volatility dW
+    const float sqrtDt = std::sqrt(dt);
+    float *v = batch.speed.data();
+    const float *mu = batch.desired.data();
+    const float *theta = batch.reversion.data();
+    const float *sigma = batch.volatility.data();
+    for (size_t i = 0; i < n; ++i) {
+        float next = v[i] + theta[i] * (mu[i] - v[i]) * dt + sigma[i] * sqrtDt * z[i];
+        v[i] = std::max(next, 0.f);
+    }
+}
@@ -0,0 +1,44 @@
+// DriverBehavior.h
+
+#ifndef DRIVER_BEHAVIOR_H
+#define DRIVER_BEHAVIOR_H
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+enum DriverProfile { CAUTIOUS, NORMAL, AGGRESSIVE, NUM_DRIVER_PROFILES };
+
+// Speed process of a driver: an Ornstein-Uhlenbeck process around a desired
+// speed set as a fraction of the vehicle's speed limit
+struct DriverProfileParams {
+    const char *name;
+    float share;        // fraction of drivers with this profile
+    float desiredRatio; // desired speed / speed limit
+    float reversion;    // pull back towards the desired speed, per second
+    float volatility;   // speed noise, in speed units per sqrt(second)
+};
+
+const DriverProfileParams &driverProfileParams(DriverProfile profile);
+
+// Picks a profile according to the profile shares
+DriverProfile sampleDriverProfile(std::mt19937 &gen);
+
+// Speed of a fresh driver drawn from the process's stationary distribution
+float sampleInitialSpeed(DriverProfile profile, float speedLimit, std::mt19937 &gen);
+
+// Speed processes of all moving vehicles in structure-of-arrays form
+struct SpeedProcessBatch {
+    std::vector<float> speed, desired, reversion, volatility, noise;
+
+    void clear();
+    void reserve(size_t n);
+    void add(float currentSpeed, DriverProfile profile, float speedLimit);
+    size_t size() const { return speed.size(); }
+};
+
+// Advances every speed process by dt seconds. The normal draws are made in a
+// separate pass so the update loop itself is branch-free and vectorizes.
+void updateSpeedProcesses(SpeedProcessBatch &batch, float dt, std::mt19937 &gen);
+
+#endif // DRIVER_BEHAVIOR_H
@@ -0,0 +1,66 @@
+// Ecs.cpp
+
+#include "Ecs.h"
+
+size_t Registry::nextComponentTypeId() {
+    static size_t next = 0;
+    return next++;
+}
+
+Entity Registry::create() {
+    Entity e;
+    if (!freeIndices.empty()) {
+        e.index = freeIndices.back();
+        freeIndices.pop_back();
+    } else {
+        e.index = static_cast<uint32_t>(generations.size());
+        generations.push_back(0);
+    }
+    e.generation = generations[e.index];
+    living++;
+    return e;
+}
+
+void Registry::destroy(Entity e) {
+    if (!alive(e)) return;
+    generations[e.index]++;
+    pendingFree.push_back(e.index);
+    living--;
+}
+
+void Registry::flush(bool parallel) {
+    if (pendingFree.empty()) return;
+    for (auto &pool : pools) {
+        if (pool) pool->compact(generations, parallel);
+    }
+    freeIndices.insert(freeIndices.end(), pendingFree.begin(), pendingFree.end());
+    pendingFree.clear();
+}
+
+void Registry::reserve(size_t n) {
+    generations.reserve(n);
+    freeIndices.reserve(n);
+    pendingFree.reserve(n);
+    for (auto &pool : pools) {
+        if (pool) pool->reserve(n);
+    }
+}
+
+void SystemTimer::record(const char *name, double ms, size_t entities) {
+    SystemStats *entry = nullptr;
+    for (auto &s : stats) {
+        if (s.name == name) {
+            entry = &s;
+            break;
+        }
+    }
+    if (!entry) {
+        stats.push_back(SystemStats());
+        entry = &stats.back();
+        entry->name = name;
+    }
+    entry->runs++;
+    entry->lastMs = ms;
+    entry->totalMs += ms;
+    entry->lastEntities = entities;
+}
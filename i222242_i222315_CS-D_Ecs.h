@@ -0,0 +1,190 @@
+// Ecs.h
+
+#ifndef ECS_H
+#define ECS_H
+
+#include "ParallelStep.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const uint32_t NO_ENTITY_INDEX = 0xffffffffu;
+
+// Entity handle: a slot index plus the generation the slot had when the entity
+// was created, so a handle to a destroyed entity never matches its successor
+struct Entity {
+    uint32_t index = NO_ENTITY_INDEX;
+    uint32_t generation = 0;
+    bool operator==(const Entity &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity &other) const { return !(*this == other); }
+};
+
+class ComponentPoolBase {
+public:
+    virtual ~ComponentPoolBase() {}
+    // Drops the components of entities whose generation no longer matches
+    virtual void compact(const std::vector<uint32_t> &generations, bool parallel) = 0;
+    virtual void reserve(size_t n) = 0;
+};
+
+// Sparse set: components sit densely in insertion order, and `sparse` maps an
+// entity index to its dense position. Systems walk the dense array directly.
+template <typename T>
+class ComponentPool : public ComponentPoolBase {
+public:
+    struct Slot {
+        Entity entity;
+        T value;
+    };
+
+private:
+    std::vector<Slot> dense;
+    std::vector<uint32_t> sparse;
+
+public:
+    T &add(Entity e, T value) {
+        if (e.index >= sparse.size()) sparse.resize(e.index + 1, NO_ENTITY_INDEX);
+        if (has(e)) {
+            Slot &slot = dense[sparse[e.index]];
+            slot.value = std::move(value);
+            return slot.value;
+        }
+        sparse[e.index] = static_cast<uint32_t>(dense.size());
+        dense.push_back({e, std::move(value)});
+        return dense.back().value;
+    }
+
+    // Swap-and-pop; not to be used while a system walks this pool
+    void remove(Entity e) {
+        if (!has(e)) return;
+        uint32_t pos = sparse[e.index];
+        if (pos + 1 != dense.size()) {
+            dense[pos] = std::move(dense.back());
+            sparse[dense[pos].entity.index] = pos;
+        }
+        dense.pop_back();
+        sparse[e.index] = NO_ENTITY_INDEX;
+    }
+
+    bool has(Entity e) const {
+        if (e.index >= sparse.size()) return false;
+        uint32_t pos = sparse[e.index];
+        return pos < dense.size() && dense[pos].entity == e;
+    }
+
+    T &get(Entity e) { return dense[sparse[e.index]].value; }
+    T *find(Entity e) { return has(e) ? &dense[sparse[e.index]].value : nullptr; }
+
+    size_t size() const { return dense.size(); }
+    void reserve(size_t n) override {
+        dense.reserve(n);
+        sparse.reserve(n);
+    }
+    Entity entityAt(size_t pos) const { return dense[pos].entity; }
+    T &valueAt(size_t pos) { return dense[pos].value; }
+
+    void compact(const std::vector<uint32_t> &generations, bool parallel) override {
+        parallelCompact(dense, parallel,
+                        [&](const Slot &slot) { return generations[slot.entity.index] != slot.entity.generation; });
+        parallelForChunks(dense.size(), parallel, [&](size_t begin, size_t end) {
+            for (size_t pos = begin; pos < end; ++pos) {
+                sparse[dense[pos].entity.index] = static_cast<uint32_t>(pos);
+            }
+        });
+    }
+};
+
+// Entities and their component pools. destroy() takes effect at once for alive(),
+// has() and each(), but components are only dropped, and slots reused, at the next
+// flush(), so systems may destroy entities while walking a pool.
+class Registry {
+private:
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> freeIndices;
+    std::vector<uint32_t> pendingFree; // destroyed since the last flush
+    std::vector<std::unique_ptr<ComponentPoolBase>> pools;
+    size_t living = 0;
+
+    static size_t nextComponentTypeId();
+    template <typename T>
+    static size_t componentTypeId() {
+        static const size_t id = nextComponentTypeId();
+        return id;
+    }
+
+public:
+    Entity create();
+    void destroy(Entity e);
+    bool alive(Entity e) const {
+        return e.index < generations.size() && generations[e.index] == e.generation;
+    }
+    void flush(bool parallel = true);
+    size_t size() const { return living; }
+    // Room for n entities in the entity tables and in every pool made so far
+    void reserve(size_t n);
+
+    template <typename T>
+    ComponentPool<T> &pool() {
+        size_t id = componentTypeId<T>();
+        if (id >= pools.size()) pools.resize(id + 1);
+        if (!pools[id]) pools[id].reset(new ComponentPool<T>());
+        return static_cast<ComponentPool<T> &>(*pools[id]);
+    }
+
+    template <typename T>
+    T &add(Entity e, T value) { return pool<T>().add(e, std::move(value)); }
+    template <typename T>
+    void remove(Entity e) { pool<T>().remove(e); }
+    template <typename T>
+    bool has(Entity e) { return alive(e) && pool<T>().has(e); }
+    template <typename T>
+    T &get(Entity e) { return pool<T>().get(e); }
+    template <typename T>
+    T *find(Entity e) { return alive(e) ? pool<T>().find(e) : nullptr; }
+
+    // Calls fn(entity, T&, Others&...) for each live entity that has all the
+    // components, walking T's pool. fn must not add T components.
+    // Returns the number of entities visited.
+    template <typename T, typename... Others, typename Fn>
+    size_t each(Fn fn) {
+        ComponentPool<T> &primary = pool<T>();
+        size_t visited = 0;
+        for (size_t pos = 0; pos < primary.size(); ++pos) {
+            Entity e = primary.entityAt(pos);
+            if (!alive(e) || !(pool<Others>().has(e) && ...)) continue;
+            fn(e, primary.valueAt(pos), pool<Others>().get(e)...);
+            visited++;
+        }
+        return visited;
+    }
+};
+
+struct SystemStats {
+    std::string name;
+    long long runs = 0;
+    double lastMs = 0.0;
+    double totalMs = 0.0;
+    size_t lastEntities = 0; // entities the last run visited
+};
+
+// Times each system of the frame by name, in the order they first ran
+class SystemTimer {
+private:
+    std::vector<SystemStats> stats;
+    void record(const char *name, double ms, size_t entities);
+
+public:
+    // Runs fn, which returns the number of entities it visited
+    template <typename Fn>
+    void run(const char *name, Fn fn) {
+        auto start = std::chrono::steady_clock::now();
+        size_t entities = fn();
+        record(name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+               entities);
+    }
+    const std::vector<SystemStats> &getStats() const { return stats; }
+};
+
+#endif // ECS_H
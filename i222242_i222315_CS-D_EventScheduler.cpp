@@ -0,0 +1,178 @@
+// EventScheduler.cpp
+
+#include "EventScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+static const size_t MIN_BUCKETS = 2;
+static const size_t WIDTH_SAMPLE = 25;  // earliest events used to estimate the bucket width
+static const double MAX_LAG_SECONDS = 0.25; // further behind than this, real time is not caught up
+
+// True if `a` comes after `b`
+static bool later(const SimEvent &a, const SimEvent &b) {
+    return a.time > b.time || (a.time == b.time && a.seq > b.seq);
+}
+
+CalendarQueue::CalendarQueue() : buckets(MIN_BUCKETS), mask(MIN_BUCKETS - 1), width(1.0), currentSlot(0), current(0), count(0) {}
+
+unsigned long long CalendarQueue::slotOf(double time) const {
+    return static_cast<unsigned long long>(time / width);
+}
+
+void CalendarQueue::startAt(double time) {
+    currentSlot = slotOf(time);
+    current = static_cast<size_t>(currentSlot) & mask;
+}
+
+void CalendarQueue::insert(const SimEvent &event) {
+    Bucket &bucket = buckets[static_cast<size_t>(slotOf(event.time)) & mask];
+    if (bucket.empty() || !later(bucket.events.back(), event)) {
+        bucket.events.push_back(event);
+        return;
+    }
+    auto pos = std::upper_bound(bucket.events.begin() + bucket.head, bucket.events.end(), event,
+                                [](const SimEvent &a, const SimEvent &b) { return later(b, a); });
+    bucket.events.insert(pos, event);
+}
+
+void CalendarQueue::push(const SimEvent &event) {
+    // The scan only moves forward, so an event before its position moves it back
+    if (count == 0 || slotOf(event.time) < currentSlot) {
+        startAt(event.time);
+    }
+    insert(event);
+    count++;
+    if (count > 2 * buckets.size()) {
+        resize(buckets.size() * 2);
+    }
+}
+
+const SimEvent &CalendarQueue::top() {
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        const Bucket &bucket = buckets[current];
+        if (!bucket.empty() && slotOf(bucket.front().time) <= currentSlot) {
+            return bucket.front();
+        }
+        currentSlot++;
+        current = static_cast<size_t>(currentSlot) & mask;
+    }
+
+    // Nothing within a whole pass over the ring: jump straight to the earliest event
+    const SimEvent *earliest = nullptr;
+    for (const auto &bucket : buckets) {
+        if (!bucket.empty() && (!earliest || later(*earliest, bucket.front()))) {
+            earliest = &bucket.front();
+        }
+    }
+    startAt(earliest->time);
+    return *earliest;
+}
+
+SimEvent CalendarQueue::pop() {
+    SimEvent event = top();
+    Bucket &bucket = buckets[current];
+    bucket.head++;
+    if (bucket.empty()) {
+        bucket.events.clear();
+        bucket.head = 0;
+    } else if (bucket.head >= 32 && 2 * bucket.head >= bucket.events.size()) {
+        bucket.events.erase(bucket.events.begin(), bucket.events.begin() + bucket.head);
+        bucket.head = 0;
+    }
+    count--;
+    if (buckets.size() > MIN_BUCKETS && count < buckets.size() / 2) {
+        resize(buckets.size() / 2);
+    }
+    return event;
+}
+
+void CalendarQueue::resize(size_t bucketCount) {
+    std::vector<SimEvent> all;
+    all.reserve(count);
+    for (auto &bucket : buckets) {
+        all.insert(all.end(), bucket.events.begin() + bucket.head, bucket.events.end());
+    }
+
+    // New width: three times the mean spacing of the earliest events, leaving out
+    // gaps more than twice the first mean so one outlier does not stretch the buckets
+    size_t sample = std::min(all.size(), WIDTH_SAMPLE);
+    if (sample >= 2) {
+        std::partial_sort(all.begin(), all.begin() + sample, all.end(),
+                          [](const SimEvent &a, const SimEvent &b) { return later(b, a); });
+        double mean = (all[sample - 1].time - all[0].time) / (sample - 1);
+        double sum = 0.0;
+        int gaps = 0;
+        for (size_t i = 1; i < sample; ++i) {
+            double gap = all[i].time - all[i - 1].time;
+            if (gap <= 2.0 * mean) {
+                sum += gap;
+                gaps++;
+            }
+        }
+        if (gaps > 0 && sum > 0.0) {
+            width = 3.0 * sum / gaps;
+        }
+    }
+
+    buckets.assign(bucketCount, Bucket());
+    mask = bucketCount - 1;
+    const SimEvent *earliest = nullptr;
+    for (const auto &event : all) {
+        insert(event);
+        if (!earliest || later(*earliest, event)) {
+            earliest = &event;
+        }
+    }
+    if (earliest) {
+        startAt(earliest->time);
+    }
+}
+
+EventScheduler::EventScheduler(bool realTime)
+    : nextSeq(0), clock(0.0), realTime(realTime), wallAnchor(std::chrono::steady_clock::now()), simAnchor(0.0) {}
+
+void EventScheduler::setRealTime(bool enabled) {
+    realTime = enabled;
+    wallAnchor = std::chrono::steady_clock::now();
+    simAnchor = clock;
+}
+
+void EventScheduler::schedule(double time, int type, int target) {
+    queue.push({std::max(time, clock), nextSeq++, type, target});
+    stats.peakPending = std::max(stats.peakPending, queue.size());
+}
+
+void EventScheduler::scheduleAfter(double delay, int type, int target) {
+    schedule(clock + delay, type, target);
+}
+
+bool EventScheduler::next(SimEvent &event) {
+    if (queue.empty()) return false;
+    event = queue.pop();
+
+    if (realTime) {
+        auto due = wallAnchor + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(event.time - simAnchor));
+        auto wallNow = std::chrono::steady_clock::now();
+        if (due > wallNow) {
+            std::this_thread::sleep_until(due);
+            stats.idleSeconds += std::chrono::duration<double>(due - wallNow).count();
+        } else if (std::chrono::duration<double>(wallNow - due).count() > MAX_LAG_SECONDS) {
+            // A slow stretch: carry on from here rather than rushing to catch up
+            wallAnchor = wallNow;
+            simAnchor = event.time;
+            stats.slips++;
+        }
+    }
+
+    clock = event.time;
+    stats.eventsProcessed++;
+    return true;
+}
+
+EventSchedulerStats EventScheduler::getStats() const {
+    EventSchedulerStats result = stats;
+    result.pending = queue.size();
+    return result;
+}
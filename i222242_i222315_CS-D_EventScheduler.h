@@ -0,0 +1,94 @@
+// EventScheduler.h
+
+#ifndef EVENT_SCHEDULER_H
+#define EVENT_SCHEDULER_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// A timestamped event; `type` and `target` are the owner's to interpret
+struct SimEvent {
+    double time;
+    unsigned long long seq; // ties broken in scheduling order
+    int type;
+    int target;
+};
+
+// Calendar queue (Brown, 1988): events are hashed by time into a ring of
+// buckets one `width` wide, and the dequeue scans forward from the bucket of
+// the last event. The bucket count follows the queue size and the width is
+// re-estimated from the spacing of the earliest events on every resize, so
+// push and pop stay O(1) amortized however far ahead events are scheduled.
+class CalendarQueue {
+private:
+    // Events in time order from `head`; the slots before it have been popped.
+    // A new event usually comes last, so simultaneous events append in O(1).
+    struct Bucket {
+        std::vector<SimEvent> events;
+        size_t head = 0;
+        bool empty() const { return head == events.size(); }
+        const SimEvent &front() const { return events[head]; }
+    };
+
+    std::vector<Bucket> buckets;
+    size_t mask;
+    double width;
+    unsigned long long currentSlot; // time slot the scan is at, `width` seconds each
+    size_t current;                 // its bucket
+    size_t count;
+
+    unsigned long long slotOf(double time) const;
+    void insert(const SimEvent &event);
+    void resize(size_t bucketCount);
+    void startAt(double time);
+
+public:
+    CalendarQueue();
+    void push(const SimEvent &event);
+    // Removes the earliest event; the queue must not be empty
+    SimEvent pop();
+    const SimEvent &top();
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+};
+
+struct EventSchedulerStats {
+    long long eventsProcessed = 0;
+    size_t pending = 0;
+    size_t peakPending = 0;
+    double idleSeconds = 0.0; // wall time spent waiting for the next event
+    long long slips = 0;      // times the clock was re-anchored after falling behind
+};
+
+// Simulation clock driven by a calendar queue. Time only moves from one event
+// to the next. In real-time mode next() sleeps until the event is due on the
+// wall clock, so a quiet simulation costs nothing but the sleep; otherwise it
+// jumps straight to the next event. Owned by the simulation thread: it is not
+// safe to schedule from other threads.
+class EventScheduler {
+private:
+    CalendarQueue queue;
+    unsigned long long nextSeq;
+    double clock;
+    bool realTime;
+    std::chrono::steady_clock::time_point wallAnchor; // wall time matching simAnchor
+    double simAnchor;
+    EventSchedulerStats stats;
+
+public:
+    explicit EventScheduler(bool realTime = true);
+    void setRealTime(bool realTime);
+
+    // Events are never scheduled in the past; an earlier time runs at now()
+    void schedule(double time, int type, int target = 0);
+    void scheduleAfter(double delay, int type, int target = 0);
+
+    // Takes the earliest event and advances the clock to it; false when none is left
+    bool next(SimEvent &event);
+
+    double now() const { return clock; }
+    EventSchedulerStats getStats() const;
+};
+
+#endif // EVENT_SCHEDULER_H
@@ -0,0 +1,290 @@
+// IncidentDispatch.cpp
+
+#include "IncidentDispatch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// ---------------- SpatialGrid ----------------
+
+SpatialGrid::SpatialGrid(float cellSize)
+    : cellSize(cellSize), minCellX(0), maxCellX(0), minCellY(0), maxCellY(0) {}
+
+long long SpatialGrid::cellKey(int cx, int cy) const {
+    return (static_cast<long long>(cx) << 32) ^ static_cast<long long>(static_cast<unsigned int>(cy));
+}
+
+int SpatialGrid::cellCoord(float v) const {
+    return static_cast<int>(std::floor(v / cellSize));
+}
+
+void SpatialGrid::insert(int id, float x, float y) {
+    if (entries.count(id)) {
+        move(id, x, y);
+        return;
+    }
+    int cx = cellCoord(x), cy = cellCoord(y);
+    if (entries.empty()) {
+        minCellX = maxCellX = cx;
+        minCellY = maxCellY = cy;
+    } else {
+        minCellX = std::min(minCellX, cx);
+        maxCellX = std::max(maxCellX, cx);
+        minCellY = std::min(minCellY, cy);
+        maxCellY = std::max(maxCellY, cy);
+    }
+    long long key = cellKey(cx, cy);
+    entries[id] = {x, y, key};
+    cells[key].push_back(id);
+}
+
+void SpatialGrid::remove(int id) {
+    auto it = entries.find(id);
+    if (it == entries.end()) return;
+    auto cellIt = cells.find(it->second.cell);
+    if (cellIt != cells.end()) {
+        // Empty cells are kept, so a unit driving back through one does not allocate again
+        auto &ids = cellIt->second;
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    }
+    entries.erase(it);
+}
+
+void SpatialGrid::move(int id, float x, float y) {
+    auto it = entries.find(id);
+    if (it == entries.end()) {
+        insert(id, x, y);
+        return;
+    }
+    int cx = cellCoord(x), cy = cellCoord(y);
+    if (cellKey(cx, cy) == it->second.cell) {
+        // Still in the same cell, only the position changes
+        it->second.x = x;
+        it->second.y = y;
+        return;
+    }
+    // Moves between cells in place rather than through remove and insert, which
+    // would free and reallocate the entry on every cell a tow unit drives through
+    std::vector<int> &from = cells[it->second.cell];
+    from.erase(std::remove(from.begin(), from.end(), id), from.end());
+    minCellX = std::min(minCellX, cx);
+    maxCellX = std::max(maxCellX, cx);
+    minCellY = std::min(minCellY, cy);
+    maxCellY = std::max(maxCellY, cy);
+    it->second = {x, y, cellKey(cx, cy)};
+    cells[it->second.cell].push_back(id);
+}
+
+bool SpatialGrid::contains(int id) const {
+    return entries.count(id) != 0;
+}
+
+int SpatialGrid::nearest(float x, float y) const {
+    if (entries.empty()) return -1;
+
+    int qx = cellCoord(x), qy = cellCoord(y);
+    int maxRing = std::max(std::max(std::abs(qx - minCellX), std::abs(qx - maxCellX)),
+                           std::max(std::abs(qy - minCellY), std::abs(qy - maxCellY)));
+
+    int best = -1;
+    float bestDist = std::numeric_limits<float>::max();
+    auto scanCell = [&](int cx, int cy) {
+        auto it = cells.find(cellKey(cx, cy));
+        if (it == cells.end()) return;
+        for (int id : it->second) {
+            const Entry &e = entries.at(id);
+            float d = std::hypot(e.x - x, e.y - y);
+            if (d < bestDist) {
+                bestDist = d;
+                best = id;
+            }
+        }
+    };
+
+    // Search rings of cells outwards; anything in ring r+1 is at least r cells away
+    for (int r = 0; r <= maxRing; ++r) {
+        if (r == 0) {
+            scanCell(qx, qy);
+        } else {
+            for (int dx = -r; dx <= r; ++dx) {
+                scanCell(qx + dx, qy - r);
+                scanCell(qx + dx, qy + r);
+            }
+            for (int dy = -r + 1; dy <= r - 1; ++dy) {
+                scanCell(qx - r, qy + dy);
+                scanCell(qx + r, qy + dy);
+            }
+        }
+        if (best != -1 && bestDist <= r * cellSize) break;
+    }
+    return best;
+}
+
+// ---------------- IncidentDispatcher ----------------
+
+IncidentDispatcher::IncidentDispatcher(float cellSize, double hookupSeconds)
+    : incidentIndex(cellSize), availableUnits(cellSize), nextIncidentId(0), simTime(0.0),
+      hookupSeconds(hookupSeconds), totalClearanceSec(0.0) {}
+
+void IncidentDispatcher::setLaneEntry(const std::string &lane, float x, float y) {
+    std::lock_guard<std::mutex> lock(mtx);
+    laneEntries[lane] = {x, y};
+}
+
+int IncidentDispatcher::addTowUnit(const std::string &name, float x, float y, float speed) {
+    std::lock_guard<std::mutex> lock(mtx);
+    TowUnit unit;
+    unit.id = static_cast<int>(units.size());
+    unit.name = name;
+    unit.x = unit.homeX = x;
+    unit.y = unit.homeY = y;
+    unit.speed = speed;
+    units.push_back(unit);
+    availableUnits.insert(unit.id, x, y);
+    return unit.id;
+}
+
+int IncidentDispatcher::reportIncident(const std::string &vehicleID, const std::string &lane, float x, float y) {
+    std::lock_guard<std::mutex> lock(mtx);
+    Incident incident;
+    incident.id = nextIncidentId++;
+    incident.vehicleID = vehicleID;
+    incident.laneName = lane;
+    incident.x = x;
+    incident.y = y;
+    incident.reportedAt = simTime;
+    incidents[incident.id] = incident;
+    laneBlocks[lane]++;
+    stats.incidentsReported++;
+
+    int unitId = availableUnits.nearest(x, y);
+    if (unitId != -1) {
+        assign(unitId, incident.id);
+    } else {
+        // Wait for the first unit to come free
+        incidentIndex.insert(incident.id, x, y);
+    }
+    return incident.id;
+}
+
+void IncidentDispatcher::assign(int unitId, int incidentId) {
+    TowUnit &unit = units[unitId];
+    Incident &incident = incidents[incidentId];
+    availableUnits.remove(unitId);
+    incidentIndex.remove(incidentId);
+    unit.incident = incidentId;
+    unit.state = TOW_EN_ROUTE;
+    incident.towUnit = unitId;
+    buildRoute(unit, incident);
+}
+
+void IncidentDispatcher::buildRoute(TowUnit &unit, const Incident &incident) {
+    // Lanes are one-way: join at the lane entry, then drive down the lane to the incident
+    unit.path.clear();
+    unit.nextWaypoint = 0;
+    auto entry = laneEntries.find(incident.laneName);
+    if (entry != laneEntries.end()) {
+        unit.path.push_back(entry->second);
+    }
+    unit.path.push_back({incident.x, incident.y});
+}
+
+bool IncidentDispatcher::advance(TowUnit &unit, float dt) {
+    float budget = unit.speed * dt;
+    while (unit.nextWaypoint < unit.path.size()) {
+        const Waypoint &target = unit.path[unit.nextWaypoint];
+        float dx = target.x - unit.x;
+        float dy = target.y - unit.y;
+        float dist = std::hypot(dx, dy);
+        if (dist <= budget) {
+            unit.x = target.x;
+            unit.y = target.y;
+            budget -= dist;
+            unit.nextWaypoint++;
+        } else {
+            unit.x += dx / dist * budget;
+            unit.y += dy / dist * budget;
+            return false;
+        }
+    }
+    return true;
+}
+
+void IncidentDispatcher::update(float dt) {
+    std::lock_guard<std::mutex> lock(mtx);
+    simTime += dt;
+
+    for (auto &unit : units) {
+        switch (unit.state) {
+        case TOW_EN_ROUTE:
+            if (advance(unit, dt)) {
+                unit.state = TOW_CLEARING;
+                unit.clearingUntil = simTime + hookupSeconds;
+            }
+            break;
+
+        case TOW_CLEARING:
+            if (simTime >= unit.clearingUntil) {
+                Incident &incident = incidents[unit.incident];
+                double clearance = simTime - incident.reportedAt;
+                stats.incidentsCleared++;
+                totalClearanceSec += clearance;
+                stats.avgClearanceSec = totalClearanceSec / stats.incidentsCleared;
+                stats.maxClearanceSec = std::max(stats.maxClearanceSec, clearance);
+
+                if (--laneBlocks[incident.laneName] <= 0) {
+                    laneBlocks.erase(incident.laneName);
+                }
+                clearedVehicles.push_back(incident.vehicleID);
+                incidents.erase(unit.incident);
+
+                // Head home, but take the next job on the way if one is waiting
+                unit.incident = -1;
+                unit.state = TOW_RETURNING;
+                unit.path.assign(1, Waypoint{unit.homeX, unit.homeY});
+                unit.nextWaypoint = 0;
+                availableUnits.insert(unit.id, unit.x, unit.y);
+
+                int next = incidentIndex.nearest(unit.x, unit.y);
+                if (next != -1) {
+                    assign(unit.id, next);
+                }
+            }
+            break;
+
+        case TOW_RETURNING:
+            if (advance(unit, dt)) {
+                unit.state = TOW_AVAILABLE;
+            }
+            availableUnits.move(unit.id, unit.x, unit.y);
+            break;
+
+        case TOW_AVAILABLE:
+            break;
+        }
+    }
+}
+
+std::vector<std::string> IncidentDispatcher::takeClearedVehicles() {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<std::string> cleared;
+    cleared.swap(clearedVehicles);
+    return cleared;
+}
+
+bool IncidentDispatcher::isLaneBlocked(const std::string &lane) {
+    std::lock_guard<std::mutex> lock(mtx);
+    return laneBlocks.count(lane) != 0;
+}
+
+std::vector<TowUnit> IncidentDispatcher::getTowUnits() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return units;
+}
+
+DispatchStats IncidentDispatcher::getStats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    DispatchStats current = stats;
+    current.incidentsActive = static_cast<int>(incidents.size());
+    return current;
+}
@@ -0,0 +1,112 @@
+// IncidentDispatch.h
+
+#ifndef INCIDENT_DISPATCH_H
+#define INCIDENT_DISPATCH_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over the intersection used to find the nearest point of interest
+class SpatialGrid {
+private:
+    struct Entry {
+        float x, y;
+        long long cell;
+    };
+    float cellSize;
+    std::unordered_map<long long, std::vector<int>> cells;
+    std::unordered_map<int, Entry> entries;
+    int minCellX, maxCellX, minCellY, maxCellY;
+
+    long long cellKey(int cx, int cy) const;
+    int cellCoord(float v) const;
+
+public:
+    explicit SpatialGrid(float cellSize);
+    void insert(int id, float x, float y);
+    void remove(int id);
+    void move(int id, float x, float y);
+    bool contains(int id) const;
+    // Returns the id closest to (x, y), or -1 if the grid is empty
+    int nearest(float x, float y) const;
+};
+
+struct Waypoint {
+    float x, y;
+};
+
+struct Incident {
+    int id;
+    std::string vehicleID;
+    std::string laneName;
+    float x, y;
+    int towUnit = -1;
+    double reportedAt = 0.0;
+};
+
+enum TowState { TOW_AVAILABLE, TOW_EN_ROUTE, TOW_CLEARING, TOW_RETURNING };
+
+struct TowUnit {
+    int id;
+    std::string name;
+    float x, y;
+    float homeX, homeY;
+    float speed; // pixels per second
+    TowState state = TOW_AVAILABLE;
+    int incident = -1;
+    std::vector<Waypoint> path;
+    size_t nextWaypoint = 0;
+    double clearingUntil = 0.0;
+};
+
+struct DispatchStats {
+    int incidentsReported = 0;
+    int incidentsCleared = 0;
+    int incidentsActive = 0;
+    double avgClearanceSec = 0.0;
+    double maxClearanceSec = 0.0;
+};
+
+// Tracks breakdowns in a spatial index, sends the nearest available tow unit
+// along the lane to each one and keeps the lane blocked until it is cleared.
+class IncidentDispatcher {
+private:
+    SpatialGrid incidentIndex;  // pending (unassigned) incidents
+    SpatialGrid availableUnits; // tow units free to take a job
+    std::map<int, Incident> incidents;
+    std::vector<TowUnit> units;
+    std::map<std::string, Waypoint> laneEntries;
+    std::map<std::string, int> laneBlocks;
+    std::vector<std::string> clearedVehicles;
+    int nextIncidentId;
+    double simTime;
+    double hookupSeconds;
+    DispatchStats stats;
+    double totalClearanceSec;
+    std::mutex mtx; // Mutex for thread safety
+
+    void assign(int unitId, int incidentId);
+    void buildRoute(TowUnit &unit, const Incident &incident);
+    bool advance(TowUnit &unit, float dt);
+
+public:
+    IncidentDispatcher(float cellSize, double hookupSeconds);
+    // Point where a tow unit joins a lane; routes follow the lane from there
+    void setLaneEntry(const std::string &lane, float x, float y);
+    int addTowUnit(const std::string &name, float x, float y, float speed);
+
+    int reportIncident(const std::string &vehicleID, const std::string &lane, float x, float y);
+    // Advances tow units by dt seconds and dispatches pending incidents
+    void update(float dt);
+    // Vehicles hauled away since the last call
+    std::vector<std::string> takeClearedVehicles();
+
+    bool isLaneBlocked(const std::string &lane);
+    std::vector<TowUnit> getTowUnits();
+    DispatchStats getStats();
+};
+
+#endif // INCIDENT_DISPATCH_H
@@ -0,0 +1,67 @@
+// LaneChange.cpp
+
+#include "LaneChange.h"
+#include <algorithm>
+#include <cmath>
+
+// Gap used when there is no vehicle ahead
+static const float FREE_ROAD_GAP = 1.0e6f;
+
+float idmAcceleration(float speed, float desiredSpeed, float gap, float leaderSpeed, const IdmParams &idm) {
+    float freeTerm = desiredSpeed > 0.f ? std::pow(speed / desiredSpeed, idm.exponent) : 1.f;
+    float approach = speed - leaderSpeed;
+    float desiredGap = idm.minGap + std::max(0.f, speed * idm.timeHeadway +
+                       speed * approach / (2.f * std::sqrt(idm.maxAccel * idm.comfortDecel)));
+    float safeGap = std::max(gap, 0.1f);
+    return idm.maxAccel * (1.f - freeTerm - (desiredGap / safeGap) * (desiredGap / safeGap));
+}
+
+size_t findFollower(const LaneSlots &lane, float progress) {
+    auto it = std::lower_bound(lane.begin(), lane.end(), progress,
+                               [](const LaneSlot &slot, float p) { return slot.progress > p; });
+    return static_cast<size_t>(it - lane.begin());
+}
+
+// Acceleration of `follower` when `leader` (may be null) is the vehicle ahead of it
+static float accelBehind(const LaneSlot &follower, const LaneSlot *leader, float desiredSpeed, const IdmParams &idm) {
+    if (!leader) {
+        return idmAcceleration(follower.speed, desiredSpeed, FREE_ROAD_GAP, follower.speed, idm);
+    }
+    return idmAcceleration(follower.speed, desiredSpeed, leader->progress - follower.progress, leader->speed, idm);
+}
+
+bool mobilShouldChange(const LaneSlots &current, size_t self, float desiredSpeed,
+                       const LaneSlots &target, bool mandatory,
+                       const IdmParams &idm, const MobilParams &mobil) {
+    const LaneSlot &me = current[self];
+    const LaneSlot *oldLeader = self > 0 ? &current[self - 1] : nullptr;
+    const LaneSlot *oldFollower = self + 1 < current.size() ? &current[self + 1] : nullptr;
+
+    size_t f = findFollower(target, me.progress);
+    const LaneSlot *newLeader = f > 0 ? &target[f - 1] : nullptr;
+    const LaneSlot *newFollower = f < target.size() ? &target[f] : nullptr;
+
+    // Gap acceptance: there must be physical room on both sides
+    if (newLeader && newLeader->progress - me.progress < idm.minGap) return false;
+    if (newFollower && me.progress - newFollower->progress < idm.minGap) return false;
+
+    // Safety: the new follower must not have to brake harder than safeDecel.
+    // Followers are assumed to share the lane's desired speed.
+    float newFollowerBefore = 0.f, newFollowerAfter = 0.f;
+    if (newFollower) {
+        newFollowerBefore = accelBehind(*newFollower, newLeader, desiredSpeed, idm);
+        newFollowerAfter = accelBehind(*newFollower, &me, desiredSpeed, idm);
+        if (newFollowerAfter < -mobil.safeDecel) return false;
+    }
+
+    if (mandatory) return true;
+
+    // Incentive: own gain plus the politeness-weighted gain of both followers
+    float ownGain = accelBehind(me, newLeader, desiredSpeed, idm) - accelBehind(me, oldLeader, desiredSpeed, idm);
+    float othersGain = newFollowerAfter - newFollowerBefore;
+    if (oldFollower) {
+        othersGain += accelBehind(*oldFollower, oldLeader, desiredSpeed, idm) -
+                      accelBehind(*oldFollower, &me, desiredSpeed, idm);
+    }
+    return ownGain + mobil.politeness * othersGain > mobil.threshold;
+}
@@ -0,0 +1,47 @@
+// LaneChange.h
+
+#ifndef LANE_CHANGE_H
+#define LANE_CHANGE_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// One vehicle in a lane's front-to-back order (progress strictly decreasing)
+struct LaneSlot {
+    float progress; // distance travelled along the lane
+    float speed;
+};
+
+// A lane's vehicles front to back; polymorphic so the caller can build it in step arena memory
+typedef std::pmr::vector<LaneSlot> LaneSlots;
+
+// Intelligent Driver Model, in simulation units (speed units, pixels)
+struct IdmParams {
+    float minGap = 30.f;       // jam distance s0
+    float timeHeadway = 0.5f;  // pixels of gap per unit of speed
+    float maxAccel = 1.f;
+    float comfortDecel = 2.f;
+    float exponent = 4.f;
+};
+
+// MOBIL lane-change criterion
+struct MobilParams {
+    float politeness = 0.3f;   // weight given to the followers' gain/loss
+    float threshold = 0.2f;    // minimum net gain before changing lanes
+    float safeDecel = 4.f;     // hardest braking the new follower may be forced into
+};
+
+float idmAcceleration(float speed, float desiredSpeed, float gap, float leaderSpeed, const IdmParams &idm);
+
+// Index of the first vehicle at or behind `progress` (lane.size() if none).
+// Binary search over the lane's sorted order.
+size_t findFollower(const LaneSlots &lane, float progress);
+
+// Decides whether the vehicle at `self` in `current` should move into `target`.
+// A mandatory change (e.g. a blockage ahead) only has to pass the gap and safety tests.
+bool mobilShouldChange(const LaneSlots &current, size_t self, float desiredSpeed,
+                       const LaneSlots &target, bool mandatory,
+                       const IdmParams &idm, const MobilParams &mobil);
+
+#endif // LANE_CHANGE_H
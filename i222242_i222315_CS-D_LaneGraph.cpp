@@ -0,0 +1,119 @@
+// LaneGraph.cpp
+
+#include "LaneGraph.h"
+
+LaneGraph::LaneGraph() : lastVisited(0) {}
+
+int LaneGraph::addLane(const std::string &name, int capacity) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = index.find(name);
+    if (it != index.end()) return it->second;
+
+    LaneNode node;
+    node.name = name;
+    node.capacity = capacity;
+    node.effectiveCapacity = capacity;
+    nodes.push_back(node);
+    worklist.reserve(nodes.size()); // a node is on the worklist at most once
+    int id = static_cast<int>(nodes.size()) - 1;
+    index[name] = id;
+    return id;
+}
+
+void LaneGraph::connect(const std::string &upstream, const std::string &downstream) {
+    std::lock_guard<std::mutex> lock(mtx);
+    int up = index.at(upstream);
+    int down = index.at(downstream);
+    nodes[up].downstream.push_back(down);
+    nodes[down].upstream.push_back(up);
+}
+
+void LaneGraph::markDirty(int node) {
+    if (!nodes[node].dirty) {
+        nodes[node].dirty = true;
+        worklist.push_back(node);
+    }
+}
+
+void LaneGraph::setOccupancy(const std::string &lane, int occupancy) {
+    std::lock_guard<std::mutex> lock(mtx);
+    LaneNode &node = nodes[index.at(lane)];
+    // Only a change on either side of the capacity threshold can flip the lane's state
+    bool wasFull = node.occupancy >= node.effectiveCapacity;
+    node.occupancy = occupancy;
+    if ((occupancy >= node.effectiveCapacity) != wasFull) {
+        markDirty(index.at(lane));
+    }
+}
+
+void LaneGraph::setBlocked(const std::string &lane, bool blocked, int effectiveCapacity) {
+    std::lock_guard<std::mutex> lock(mtx);
+    int id = index.at(lane);
+    LaneNode &node = nodes[id];
+    int capacity = blocked ? effectiveCapacity : node.capacity;
+    if (node.blocked != blocked || node.effectiveCapacity != capacity) {
+        node.blocked = blocked;
+        node.effectiveCapacity = capacity;
+        markDirty(id);
+    }
+}
+
+void LaneGraph::propagateLocked() {
+    if (worklist.empty()) return;
+    lastVisited = 0;
+    while (!worklist.empty()) {
+        int id = worklist.back();
+        worklist.pop_back();
+        LaneNode &node = nodes[id];
+        node.dirty = false;
+        lastVisited++;
+
+        // A lane is held when it has somewhere to go but every exit is spilled back
+        bool held = !node.downstream.empty();
+        for (int down : node.downstream) {
+            if (!nodes[down].spilledBack) {
+                held = false;
+                break;
+            }
+        }
+        node.held = held;
+
+        bool spilled = node.occupancy >= node.effectiveCapacity;
+        if (spilled != node.spilledBack) {
+            node.spilledBack = spilled;
+            for (int up : node.upstream) {
+                markDirty(up);
+            }
+        }
+    }
+}
+
+int LaneGraph::propagate() {
+    std::lock_guard<std::mutex> lock(mtx);
+    propagateLocked();
+    return lastVisited;
+}
+
+bool LaneGraph::canEnter(const std::string &lane) {
+    std::lock_guard<std::mutex> lock(mtx);
+    propagateLocked();
+    const LaneNode &node = nodes[index.at(lane)];
+    return !node.spilledBack;
+}
+
+bool LaneGraph::isSpilledBack(const std::string &lane) {
+    std::lock_guard<std::mutex> lock(mtx);
+    propagateLocked();
+    return nodes[index.at(lane)].spilledBack;
+}
+
+bool LaneGraph::isHeld(const std::string &lane) {
+    std::lock_guard<std::mutex> lock(mtx);
+    propagateLocked();
+    return nodes[index.at(lane)].held;
+}
+
+int LaneGraph::getLastVisited() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return lastVisited;
+}
@@ -0,0 +1,61 @@
+// LaneGraph.h
+
+#ifndef LANE_GRAPH_H
+#define LANE_GRAPH_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct LaneNode {
+    std::string name;
+    int capacity;          // vehicles the lane holds when clear
+    int effectiveCapacity; // reduced while an incident blocks part of the lane
+    int occupancy = 0;
+    bool blocked = false;  // an incident stops discharge from this lane
+    bool held = false;     // every downstream lane is spilled back
+    bool spilledBack = false;
+    bool dirty = false;
+    std::vector<int> upstream;
+    std::vector<int> downstream;
+};
+
+// Lane capacity model for incident-driven spillback.
+// A lane spills back once it is full; a lane whose downstream lanes have all
+// spilled back is held and fills up in turn. Changes are pushed through a
+// worklist, so propagation only visits the lanes whose state actually flips
+// and their direct upstream neighbours.
+class LaneGraph {
+private:
+    std::vector<LaneNode> nodes;
+    std::map<std::string, int> index;
+    std::vector<int> worklist;
+    int lastVisited;
+    std::mutex mtx; // Mutex for thread safety
+
+    void markDirty(int node);
+    void propagateLocked();
+
+public:
+    LaneGraph();
+    int addLane(const std::string &name, int capacity);
+    // Vehicles leave `upstream` by entering `downstream`
+    void connect(const std::string &upstream, const std::string &downstream);
+
+    void setOccupancy(const std::string &lane, int occupancy);
+    // Marks a lane blocked (or clear) and limits how many vehicles fit before the blockage
+    void setBlocked(const std::string &lane, bool blocked, int effectiveCapacity);
+
+    // Processes pending changes; returns the number of lanes visited
+    int propagate();
+
+    // True when the lane has room and is not spilled back
+    bool canEnter(const std::string &lane);
+    bool isSpilledBack(const std::string &lane);
+    // True when the lane cannot discharge because its downstream lanes are full
+    bool isHeld(const std::string &lane);
+    int getLastVisited();
+};
+
+#endif // LANE_GRAPH_H
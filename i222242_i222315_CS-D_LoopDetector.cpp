@@ -0,0 +1,86 @@
+// LoopDetector.cpp
+
+#include "LoopDetector.h"
+#include <algorithm>
+
+LoopDetectorBank::LoopDetectorBank(double samplePeriod, float vehicleLength)
+    : samplePeriod(samplePeriod), vehicleLength(vehicleLength), periodStart(-1.0), lastObserve(-1.0), dropped(0) {}
+
+int LoopDetectorBank::addDetector(const std::string &lane, float position, float length) {
+    Detector detector;
+    detector.lane = lane;
+    detector.position = position;
+    detector.length = length;
+    detectors.push_back(detector);
+    return static_cast<int>(detectors.size()) - 1;
+}
+
+DetectorRing *LoopDetectorBank::subscribe(size_t capacity) {
+    subscribers.emplace_back(new DetectorRing(capacity));
+    return subscribers.back().get();
+}
+
+void LoopDetectorBank::observe(const LaneFronts &laneFronts, double now) {
+    if (periodStart < 0.0) {
+        periodStart = lastObserve = now;
+    }
+    double dt = now - lastObserve;
+    lastObserve = now;
+
+    for (auto &detector : detectors) {
+        // A vehicle covers the loop while its front is between the loop's near
+        // edge and one vehicle length past its far edge
+        bool occupied = false;
+        auto lane = laneFronts.find(detector.lane);
+        if (lane != laneFronts.end()) {
+            const std::pmr::vector<float> &fronts = lane->second;
+            float farEdge = detector.position + detector.length + vehicleLength;
+            auto it = std::lower_bound(fronts.begin(), fronts.end(), farEdge,
+                                       [](float front, float edge) { return front > edge; });
+            occupied = it != fronts.end() && *it >= detector.position;
+        }
+
+        if (occupied) {
+            detector.occupiedSeconds += dt;
+            if (!detector.occupied) {
+                // Rising edge: a new vehicle arrived on the loop
+                detector.count++;
+                if (detector.lastArrival >= 0.0) {
+                    detector.headwaySum += now - detector.lastArrival;
+                    detector.headways++;
+                }
+                detector.lastArrival = now;
+            }
+        }
+        detector.occupied = occupied;
+    }
+
+    if (now - periodStart >= samplePeriod) {
+        emitSamples(now);
+    }
+}
+
+void LoopDetectorBank::emitSamples(double now) {
+    double period = now - periodStart;
+    for (size_t i = 0; i < detectors.size(); ++i) {
+        Detector &detector = detectors[i];
+        DetectorSample sample;
+        sample.detector = static_cast<int>(i);
+        sample.time = now;
+        sample.occupancy = period > 0.0 ? static_cast<float>(std::min(1.0, detector.occupiedSeconds / period)) : 0.f;
+        sample.count = detector.count;
+        sample.meanHeadway = detector.headways > 0 ? static_cast<float>(detector.headwaySum / detector.headways) : 0.f;
+
+        for (auto &subscriber : subscribers) {
+            if (!subscriber->push(sample)) {
+                dropped++;
+            }
+        }
+
+        detector.occupiedSeconds = 0.0;
+        detector.count = 0;
+        detector.headwaySum = 0.0;
+        detector.headways = 0;
+    }
+    periodStart = now;
+}
@@ -0,0 +1,108 @@
+// LoopDetector.h
+
+#ifndef LOOP_DETECTOR_H
+#define LOOP_DETECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// One loop's readings over one sample period
+struct DetectorSample {
+    int detector;
+    double time;       // end of the sample period
+    float occupancy;   // fraction of the period the loop was covered
+    int count;         // vehicles that arrived on the loop
+    float meanHeadway; // seconds between arrivals, 0 with fewer than two
+};
+
+// Single-producer single-consumer ring buffer. push() and pop() never block;
+// when the consumer falls behind, push() drops the new item.
+template <typename T>
+class SpscRing {
+private:
+    std::vector<T> slots;
+    size_t mask;
+    std::atomic<size_t> head; // next slot to read, advanced by the consumer
+    std::atomic<size_t> tail; // next slot to write, advanced by the producer
+
+public:
+    explicit SpscRing(size_t capacity) : head(0), tail(0) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    bool push(const T &item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+typedef SpscRing<DetectorSample> DetectorRing;
+
+// Vehicle fronts per lane for one step, furthest first; usually in step arena memory
+typedef std::pmr::map<std::string, std::pmr::vector<float>> LaneFronts;
+
+// Virtual inductive loops placed along lanes.
+// Every simulation step the producer passes each lane's vehicle fronts in lane
+// order (furthest first); a binary search finds the vehicles over each loop, so
+// a step costs O(detectors * log vehicles) plus the vehicles near the loops.
+// Once per sample period every detector's occupancy, count and headway are
+// pushed to each subscriber's ring. Detectors and subscribers must be added
+// before the first observe(); after that only the producer touches the bank.
+class LoopDetectorBank {
+private:
+    struct Detector {
+        std::string lane;
+        float position;      // distance of the loop's near edge from the lane entry
+        float length;
+        bool occupied = false;
+        double occupiedSeconds = 0.0;
+        int count = 0;
+        double lastArrival = -1.0;
+        double headwaySum = 0.0;
+        int headways = 0;
+    };
+
+    std::vector<Detector> detectors;
+    std::vector<std::unique_ptr<DetectorRing>> subscribers;
+    double samplePeriod;
+    float vehicleLength;
+    double periodStart;
+    double lastObserve;
+    std::atomic<long long> dropped;
+
+    void emitSamples(double now);
+
+public:
+    LoopDetectorBank(double samplePeriod, float vehicleLength);
+    int addDetector(const std::string &lane, float position, float length);
+    // Returns a ring owned by the bank, to be drained by a single consumer thread
+    DetectorRing *subscribe(size_t capacity);
+
+    // Records one step; `laneFronts` maps each lane to its vehicles' progress, furthest first
+    void observe(const LaneFronts &laneFronts, double now);
+
+    const std::string &getLane(int detector) const { return detectors[detector].lane; }
+    size_t size() const { return detectors.size(); }
+    long long getDropped() const { return dropped.load(); }
+};
+
+#endif // LOOP_DETECTOR_H
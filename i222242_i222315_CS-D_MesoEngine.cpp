@@ -0,0 +1,343 @@
+// MesoEngine.cpp
+
+#include "MesoEngine.h"
+#include <algorithm>
+#include <limits>
+
+// Grid steps and turns for each MesoDirection
+static const int gridRowStep[4] = {1, -1, 0, 0};
+static const int gridColStep[4] = {0, 0, -1, 1};
+static const int gridLeftTurn[4] = {MESO_EASTBOUND, MESO_WESTBOUND, MESO_SOUTHBOUND, MESO_NORTHBOUND};
+static const int gridRightTurn[4] = {MESO_WESTBOUND, MESO_EASTBOUND, MESO_NORTHBOUND, MESO_SOUTHBOUND};
+
+// Simulated time without a completed trip after which the network is taken to be gridlocked
+static const double STALL_SECONDS = 3600.0;
+
+MesoEngine::MesoEngine(unsigned int seed)
+    : gridFirstLink(0), gridRows(0), gridCols(0), nextSeq(0), now(0.0), tripLimit(std::numeric_limits<long long>::max()),
+      totalTravelTime(0.0), totalDelay(0.0), lastCompletion(0.0), gen(seed) {}
+
+void MesoEngine::schedule(double time, int type, int target) {
+    events.push({time, nextSeq++, type, target});
+}
+
+int MesoEngine::addSignal(double green, double amber, double offset) {
+    MesoSignal signal;
+    signal.green = green;
+    signal.amber = amber;
+    signals.push_back(signal);
+    int id = static_cast<int>(signals.size()) - 1;
+    // `offset` seconds of the first green have already run at time zero
+    schedule(now + std::max(0.0, green - offset), SIGNAL_CHANGE, id);
+    return id;
+}
+
+int MesoEngine::addLink(float length, float freeSpeed, double headway, int maxCapacity, int signal, int phase) {
+    MesoLink link;
+    link.freeFlowTime = length / freeSpeed;
+    link.headway = headway;
+    link.maxCapacity = maxCapacity;
+    link.signal = signal;
+    link.phase = phase;
+    links.push_back(link);
+    int id = static_cast<int>(links.size()) - 1;
+    if (signal >= 0) {
+        signals[signal].links.push_back(id);
+    }
+    return id;
+}
+
+void MesoEngine::connect(int from, int to, float share) {
+    MesoLink &link = links[from];
+    link.downstream.push_back(to);
+    link.turnShare.push_back((link.turnShare.empty() ? 0.f : link.turnShare.back()) + share);
+}
+
+void MesoEngine::setDemand(int link, double tripsPerSecond) {
+    links[link].demand = tripsPerSecond;
+    if (tripsPerSecond > 0.0) {
+        std::exponential_distribution<double> interArrival(tripsPerSecond);
+        schedule(now + interArrival(gen), TRIP_ARRIVAL, link);
+    }
+}
+
+int MesoEngine::buildGrid(int rows, int cols, const MesoGridParams &params) {
+    int firstLink = static_cast<int>(links.size());
+    int firstSignal = static_cast<int>(signals.size());
+    gridFirstLink = firstLink;
+    gridRows = rows;
+    gridCols = cols;
+    auto linkId = [&](int r, int c, int d) { return gridLink(r, c, d); };
+    auto inside = [&](int r, int c) { return r >= 0 && r < rows && c >= 0 && c < cols; };
+
+    for (int i = 0; i < rows * cols; ++i) {
+        addSignal(params.green, params.amber, 0.0);
+    }
+
+    int capacity = std::max(1, static_cast<int>(params.linkLength / params.vehicleSpacing)) * params.lanes;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            for (int d = 0; d < 4; ++d) {
+                addLink(params.linkLength, params.freeSpeed, params.laneHeadway / params.lanes, capacity,
+                        firstSignal + r * cols + c, d < 2 ? 0 : 1);
+            }
+        }
+    }
+
+    float turnShare = (1.f - params.straightShare) / 2.f;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            for (int d = 0; d < 4; ++d) {
+                int id = linkId(r, c, d);
+                const int moves[3] = {d, gridLeftTurn[d], gridRightTurn[d]};
+                const float shares[3] = {params.straightShare, turnShare, turnShare};
+                for (int m = 0; m < 3; ++m) {
+                    int nr = r + gridRowStep[moves[m]], nc = c + gridColStep[moves[m]];
+                    connect(id, inside(nr, nc) ? linkId(nr, nc, moves[m]) : -1, shares[m]);
+                }
+                // Links arriving from outside the grid are where trips enter
+                if (!inside(r - gridRowStep[d], c - gridColStep[d])) {
+                    setDemand(id, params.demandPerEntry);
+                }
+            }
+        }
+    }
+    return static_cast<int>(links.size()) - firstLink;
+}
+
+int MesoEngine::gridLink(int row, int col, int direction) const {
+    return gridFirstLink + (row * gridCols + col) * 4 + direction;
+}
+
+int MesoEngine::gridExitLink(int row, int col, int direction) const {
+    int r = row + gridRowStep[direction], c = col + gridColStep[direction];
+    if (r < 0 || r >= gridRows || c < 0 || c >= gridCols) return -1;
+    return gridLink(r, c, direction);
+}
+
+void MesoEngine::setHandoffLink(int link, int maxCapacity) {
+    links[link].handoff = true;
+    links[link].maxCapacity = maxCapacity;
+}
+
+std::vector<MesoHandoff> MesoEngine::takeHandoffs() {
+    std::vector<MesoHandoff> taken;
+    taken.swap(handoffs);
+    return taken;
+}
+
+void MesoEngine::releaseHandoff(int link) {
+    links[link].occupancy--;
+    freeSpace(link);
+}
+
+void MesoEngine::returnTrip(int trip, int link, double time, double freeFlowTime) {
+    trips[trip].freeFlowTime += freeFlowTime;
+    trips[trip].nextLink = link;
+    stats.tripsHandedOff--;
+    schedule(std::max(now, time), HANDOFF_RETURN, trip);
+}
+
+void MesoEngine::abandonTrip(int trip) {
+    stats.tripsHandedOff--;
+    freeTrips.push_back(trip);
+}
+
+bool MesoEngine::serves(const MesoLink &link) const {
+    if (link.signal < 0) return true;
+    const MesoSignal &signal = signals[link.signal];
+    return signal.serving && signal.phase == link.phase;
+}
+
+int MesoEngine::newTrip() {
+    if (!freeTrips.empty()) {
+        int trip = freeTrips.back();
+        freeTrips.pop_back();
+        return trip;
+    }
+    trips.push_back(MesoTrip());
+    return static_cast<int>(trips.size()) - 1;
+}
+
+void MesoEngine::enterLink(int trip, int link) {
+    MesoLink &l = links[link];
+    l.occupancy++;
+    trips[trip].link = link;
+    trips[trip].nextLink = -2;
+    if (l.handoff) {
+        handoffs.push_back({trip, link, now});
+        stats.tripsHandedOff++;
+        return;
+    }
+    trips[trip].freeFlowTime += l.freeFlowTime;
+    schedule(now + l.freeFlowTime, REACH_STOP_LINE, trip);
+}
+
+void MesoEngine::trySchedule(int link) {
+    MesoLink &l = links[link];
+    if (l.serverBusy || l.blocked || l.vehicles.empty() || !serves(l)) return;
+    l.serverBusy = true;
+    schedule(std::max(now, l.nextDeparture), DEPARTURE, link);
+}
+
+void MesoEngine::freeSpace(int link) {
+    MesoLink &l = links[link];
+    // Trips waiting at the network edge take the space first
+    while (!l.waiting.empty() && l.occupancy < l.maxCapacity) {
+        int trip = l.waiting.front();
+        l.waiting.pop_front();
+        enterLink(trip, link);
+    }
+    if (l.occupancy >= l.maxCapacity || l.blockedUpstream.empty()) return;
+
+    std::vector<int> woken;
+    woken.swap(l.blockedUpstream);
+    for (int upstream : woken) {
+        links[upstream].blocked = false;
+        trySchedule(upstream);
+    }
+}
+
+void MesoEngine::completeTrip(int trip) {
+    double travel = now - trips[trip].departTime;
+    totalTravelTime += travel;
+    totalDelay += travel - trips[trip].freeFlowTime;
+    stats.maxTravelTime = std::max(stats.maxTravelTime, travel);
+    stats.tripsCompleted++;
+    lastCompletion = now;
+    freeTrips.push_back(trip);
+}
+
+void MesoEngine::handleEvent(const SimEvent &event) {
+    switch (event.type) {
+    case TRIP_ARRIVAL: {
+        if (stats.tripsStarted >= tripLimit) return;
+        MesoLink &l = links[event.target];
+        int trip = newTrip();
+        trips[trip] = {now, 0.0, event.target, -2};
+        stats.tripsStarted++;
+        if (l.waiting.empty() && l.occupancy < l.maxCapacity) {
+            enterLink(trip, event.target);
+        } else {
+            l.waiting.push_back(trip);
+        }
+        std::exponential_distribution<double> interArrival(l.demand);
+        schedule(now + interArrival(gen), TRIP_ARRIVAL, event.target);
+        break;
+    }
+    case REACH_STOP_LINE: {
+        int link = trips[event.target].link;
+        MesoLink &l = links[link];
+        l.vehicles.push_back(event.target);
+        l.maxQueue = std::max(l.maxQueue, l.vehicles.size());
+        stats.maxQueue = std::max(stats.maxQueue, l.vehicles.size());
+        trySchedule(link);
+        break;
+    }
+    case DEPARTURE: {
+        int link = event.target;
+        MesoLink &l = links[link];
+        l.serverBusy = false;
+        if (l.vehicles.empty() || !serves(l)) return;
+
+        MesoTrip &trip = trips[l.vehicles.front()];
+        if (trip.nextLink == -2) {
+            std::uniform_real_distribution<float> pick(0.f, l.turnShare.back());
+            float u = pick(gen);
+            size_t m = std::upper_bound(l.turnShare.begin(), l.turnShare.end(), u) - l.turnShare.begin();
+            trip.nextLink = l.downstream[std::min(m, l.downstream.size() - 1)];
+        }
+
+        int next = trip.nextLink;
+        if (next >= 0 && links[next].occupancy >= links[next].maxCapacity) {
+            // Spillback: wait until the next link frees a space
+            l.blocked = true;
+            links[next].blockedUpstream.push_back(link);
+            return;
+        }
+
+        int tripId = l.vehicles.front();
+        l.vehicles.pop_front();
+        l.occupancy--;
+        l.nextDeparture = now + l.headway;
+        if (next >= 0) {
+            enterLink(tripId, next);
+        } else {
+            completeTrip(tripId);
+        }
+        freeSpace(link);
+        trySchedule(link);
+        break;
+    }
+    case HANDOFF_RETURN: {
+        // Back from the detailed region: enter the next link like a trip at the network edge
+        int link = trips[event.target].nextLink;
+        if (link < 0) {
+            completeTrip(event.target);
+        } else if (links[link].waiting.empty() && links[link].occupancy < links[link].maxCapacity) {
+            enterLink(event.target, link);
+        } else {
+            links[link].waiting.push_back(event.target);
+        }
+        break;
+    }
+    case SIGNAL_CHANGE: {
+        MesoSignal &signal = signals[event.target];
+        if (signal.serving) {
+            signal.serving = false;
+            schedule(now + signal.amber, SIGNAL_CHANGE, event.target);
+        } else {
+            signal.phase = 1 - signal.phase;
+            signal.serving = true;
+            schedule(now + signal.green, SIGNAL_CHANGE, event.target);
+            for (int link : signal.links) {
+                trySchedule(link);
+            }
+        }
+        break;
+    }
+    }
+}
+
+void MesoEngine::advanceTo(double time) {
+    while (!events.empty() && events.top().time <= time) {
+        SimEvent event = events.pop();
+        now = event.time;
+        handleEvent(event);
+        stats.eventsProcessed++;
+    }
+    now = std::max(now, time);
+}
+
+double MesoEngine::nextEventTime() {
+    return events.empty() ? std::numeric_limits<double>::infinity() : events.top().time;
+}
+
+MesoStats MesoEngine::run(long long tripCount) {
+    tripLimit = tripCount;
+    while (!events.empty() && stats.tripsCompleted < tripLimit) {
+        SimEvent event = events.pop();
+        now = event.time;
+        handleEvent(event);
+        stats.eventsProcessed++;
+
+        if (now - lastCompletion > STALL_SECONDS && stats.tripsStarted > stats.tripsCompleted) {
+            stats.gridlocked = true;
+            break;
+        }
+    }
+    return getStats();
+}
+
+MesoStats MesoEngine::getStats() const {
+    MesoStats result = stats;
+    result.simulatedSeconds = now;
+    if (stats.tripsCompleted > 0) {
+        result.meanTravelTime = totalTravelTime / stats.tripsCompleted;
+        result.meanDelay = totalDelay / stats.tripsCompleted;
+    }
+    if (now > 0.0) {
+        result.throughputPerMinute = stats.tripsCompleted / (now / 60.0);
+    }
+    return result;
+}
@@ -0,0 +1,164 @@
+// MesoEngine.h
+
+#ifndef MESO_ENGINE_H
+#define MESO_ENGINE_H
+
+#include "EventScheduler.h"
+#include <cstddef>
+#include <deque>
+#include <random>
+#include <vector>
+
+// Directions of travel on a grid; a grid link is named by the intersection it
+// arrives at and the direction it travels in. North-south links are served by phase 0.
+enum MesoDirection { MESO_SOUTHBOUND, MESO_NORTHBOUND, MESO_WESTBOUND, MESO_EASTBOUND };
+
+// Fixed-time two-phase signal at a meso intersection
+struct MesoSignal {
+    double green;        // green time of each phase, seconds
+    double amber;        // amber and all-red between phases, seconds
+    int phase = 0;       // 0 serves north-south links, 1 east-west
+    bool serving = true; // false during amber
+    std::vector<int> links; // links stopped by this signal
+};
+
+// A lane group modelled as a queue-server; the meso counterpart of LaneQueue.
+// A vehicle takes freeFlowTime to reach the stop line, joins `vehicles`, and
+// leaves one saturation headway after the previous one while its signal serves
+// it and the next link has room.
+struct MesoLink {
+    double freeFlowTime;
+    double headway;               // seconds between departures at saturation flow
+    int maxCapacity;              // vehicles the link can hold, moving or queued
+    int signal = -1;              // intersection at the downstream end, -1 if uncontrolled
+    int phase = 0;                // signal phase that serves this link
+    std::vector<int> downstream;  // next links; -1 leaves the network
+    std::vector<float> turnShare; // cumulative share of each downstream entry
+    double demand = 0.0;          // trips per second entering the network here
+    bool handoff = false;         // simulated by a detailed model; trips entering it are handed out
+
+    std::deque<int> vehicles;     // trips queued at the stop line, front first
+    std::deque<int> waiting;      // trips waiting outside the network to enter here
+    int occupancy = 0;
+    bool serverBusy = false;      // a departure event is scheduled
+    bool blocked = false;         // the front trip waits for room downstream
+    double nextDeparture = 0.0;   // earliest time the next vehicle may leave
+    std::vector<int> blockedUpstream; // links waiting for room on this link
+    size_t maxQueue = 0;
+};
+
+struct MesoTrip {
+    double departTime;   // when the trip asked to enter the network
+    double freeFlowTime; // travel time on an empty network along the links used so far
+    int link;
+    int nextLink;        // chosen at the stop line; -2 until then, -1 to leave
+};
+
+// A trip leaving the meso model for a link simulated in detail
+struct MesoHandoff {
+    int trip;
+    int link;
+    double time;
+};
+
+struct MesoStats {
+    long long tripsStarted = 0;
+    long long tripsCompleted = 0;
+    long long tripsHandedOff = 0;   // currently in the detailed region
+    long long eventsProcessed = 0;
+    double simulatedSeconds = 0.0;
+    double meanTravelTime = 0.0;
+    double meanDelay = 0.0;         // travel time beyond free flow
+    double maxTravelTime = 0.0;
+    double throughputPerMinute = 0.0;
+    size_t maxQueue = 0;
+    bool gridlocked = false;        // run() stopped because no trip could finish
+};
+
+// Layout of a rows x cols grid of signalised intersections
+struct MesoGridParams {
+    float linkLength = 600.f;       // pixels between intersections
+    int lanes = 2;
+    float freeSpeed = 36.f;         // pixels per second
+    float vehicleSpacing = 35.f;    // pixels one stored vehicle takes
+    double laneHeadway = 0.85;      // seconds between departures from one lane
+    double green = 10.0;
+    double amber = 3.0;
+    double demandPerEntry = 0.2;    // trips per second at every boundary entry
+    float straightShare = 0.7f;     // the rest turns left and right evenly
+};
+
+// Mesoscopic engine. Nothing moves between events: a trip costs two events per
+// link (reaching the stop line, leaving it) and signals one event per change,
+// so idle links cost nothing and run time grows with trips, not network size.
+class MesoEngine {
+private:
+    enum EventType { TRIP_ARRIVAL, REACH_STOP_LINE, DEPARTURE, SIGNAL_CHANGE, HANDOFF_RETURN };
+
+    std::vector<MesoLink> links;
+    std::vector<MesoSignal> signals;
+    std::vector<MesoTrip> trips;
+    std::vector<int> freeTrips;
+    std::vector<MesoHandoff> handoffs;
+    int gridFirstLink;
+    int gridRows;
+    int gridCols;
+    CalendarQueue events;
+    unsigned long long nextSeq;
+    double now;
+    long long tripLimit;
+    double totalTravelTime;
+    double totalDelay;
+    double lastCompletion;
+    std::mt19937 gen;
+    MesoStats stats;
+
+    void schedule(double time, int type, int target);
+    bool serves(const MesoLink &link) const;
+    void enterLink(int trip, int link);
+    void trySchedule(int link);
+    void freeSpace(int link);
+    void completeTrip(int trip);
+    int newTrip();
+    void handleEvent(const SimEvent &event);
+
+public:
+    explicit MesoEngine(unsigned int seed);
+    int addSignal(double green, double amber, double offset);
+    int addLink(float length, float freeSpeed, double headway, int maxCapacity, int signal, int phase);
+    // `share` is this movement's fraction of the link's departures; -1 as `to` leaves the network
+    void connect(int from, int to, float share);
+    void setDemand(int link, double tripsPerSecond);
+
+    // Builds a grid and returns the number of links
+    int buildGrid(int rows, int cols, const MesoGridParams &params);
+    // Link arriving at grid intersection (row, col) travelling in `direction`
+    int gridLink(int row, int col, int direction) const;
+    // Link a trip takes leaving (row, col) straight on in `direction`, -1 if that leaves the grid
+    int gridExitLink(int row, int col, int direction) const;
+
+    // Hybrid hand-off. Trips entering a handoff link are queued for the detailed model
+    // instead of being simulated; they count against the link's capacity until the
+    // detailed model releases them, so spillback still reaches the meso links upstream.
+    void setHandoffLink(int link, int maxCapacity);
+    std::vector<MesoHandoff> takeHandoffs();
+    void releaseHandoff(int link);
+    // Hands a trip back at `time`, entering `link` (-1 completes it); `freeFlowTime` is
+    // the free-flow time of the detailed part of its journey
+    void returnTrip(int trip, int link, double time, double freeFlowTime);
+    // Drops a trip that ended inside the detailed region without reaching the network edge
+    void abandonTrip(int trip);
+
+    // Processes every event up to `time`
+    void advanceTo(double time);
+    // Time of the next pending event, infinity when there is none
+    double nextEventTime();
+    // Runs until `trips` trips have entered and left, or the event list is empty
+    MesoStats run(long long trips);
+
+    double getTime() const { return now; }
+    MesoStats getStats() const;
+    size_t linkCount() const { return links.size(); }
+};
+
+#endif // MESO_ENGINE_H
@@ -0,0 +1,76 @@
+// ParallelStep.h
+
+#ifndef PARALLEL_STEP_H
+#define PARALLEL_STEP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <execution>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// Below this many items the thread hand-off costs more than the work, so the
+// helpers here run serially; an ordinary intersection never reaches it.
+// The simulation only asks for the parallel path with --parallel. Neither that path
+// nor this threshold has been measured on more than one core; run --step-bench at a
+// few fleet sizes there before turning it on or tuning the threshold.
+static const size_t PARALLEL_MIN_ITEMS = 4096;
+static const size_t PARALLEL_CHUNKS_PER_CORE = 4; // spare chunks so a slow one does not hold up the rest
+
+// Whether n items are worth spreading over the cores
+inline bool parallelWorthwhile(size_t n, bool parallel) {
+    return parallel && n >= PARALLEL_MIN_ITEMS && std::thread::hardware_concurrency() > 1;
+}
+
+// Calls fn(begin, end) over [0, n) in contiguous chunks, the chunks in parallel
+template <typename Fn>
+void parallelForChunks(size_t n, bool parallel, Fn fn) {
+    if (!parallelWorthwhile(n, parallel)) {
+        fn(size_t(0), n);
+        return;
+    }
+    size_t cores = std::thread::hardware_concurrency();
+    size_t chunkSize = std::max(PARALLEL_MIN_ITEMS / 4, n / (cores * PARALLEL_CHUNKS_PER_CORE) + 1);
+    std::vector<size_t> chunks((n + chunkSize - 1) / chunkSize);
+    std::iota(chunks.begin(), chunks.end(), size_t(0));
+    std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](size_t chunk) {
+        fn(chunk * chunkSize, std::min(n, (chunk + 1) * chunkSize));
+    });
+}
+
+// Stable stream compaction: drops the items `removed` picks and keeps the rest in
+// order, like erase(remove_if). In parallel, the destination of each kept item is
+// an exclusive prefix sum over the keep flags, so every item moves independently.
+// Items move into a buffer kept from the previous call, whose moved-from elements
+// are reused, so a steady population does not allocate.
+template <typename T, typename Pred>
+void parallelCompact(std::vector<T> &items, bool parallel, Pred removed) {
+    const size_t n = items.size();
+    if (!parallelWorthwhile(n, parallel)) {
+        items.erase(std::remove_if(items.begin(), items.end(), removed), items.end());
+        return;
+    }
+
+    static thread_local std::vector<size_t> destination;
+    static thread_local std::vector<T> compacted;
+    destination.resize(n);
+    std::transform_exclusive_scan(std::execution::par, items.begin(), items.end(), destination.begin(),
+                                  size_t(0), std::plus<size_t>(),
+                                  [&](const T &item) { return removed(item) ? size_t(0) : size_t(1); });
+    size_t kept = destination.back() + (removed(items.back()) ? 0 : 1);
+    if (kept == n) return;
+
+    compacted.resize(kept);
+    parallelForChunks(n, true, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!removed(items[i])) {
+                compacted[destination[i]] = std::move(items[i]);
+            }
+        }
+    });
+    items.swap(compacted);
+}
+
+#endif // PARALLEL_STEP_H
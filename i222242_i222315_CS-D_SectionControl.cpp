@@ -0,0 +1,118 @@
+// SectionControl.cpp
+
+#include "SectionControl.h"
+#include <cstring>
+
+bool SectionControl::JoinKey::operator==(const JoinKey &other) const {
+    return section == other.section && std::memcmp(plate, other.plate, sizeof(plate)) == 0;
+}
+
+// FNV-1a over the section and the plate
+size_t SectionControl::JoinKeyHash::operator()(const JoinKey &key) const {
+    uint64_t hash = 14695981039346656037ull;
+    hash = (hash ^ key.section) * 1099511628211ull;
+    for (size_t i = 0; i < sizeof(key.plate) && key.plate[i] != '\0'; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(key.plate[i])) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+SectionControl::SectionControl(double window)
+    : window(window),
+      reserved(SECTION_CONTROL_RESERVED_BYTES),
+      reservedArena(reserved.data(), reserved.size()),
+      pool(&reservedArena),
+      entries(&pool),
+      expiries(&pool) {
+    entries.reserve(SECTION_CONTROL_RESERVED_READS);
+}
+
+void SectionControl::addSection(const std::string &section, float length) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = sectionIds.find(section);
+    if (it != sectionIds.end()) {
+        sectionLengths[it->second] = length;
+        return;
+    }
+    sectionIds[section] = static_cast<uint32_t>(sectionLengths.size());
+    sectionLengths.push_back(length);
+}
+
+bool SectionControl::makeKey(const std::string &plate, const std::string &section, JoinKey &key) const {
+    auto it = sectionIds.find(section);
+    if (it == sectionIds.end()) return false;
+    key.section = it->second;
+    std::memset(key.plate, 0, sizeof(key.plate));
+    std::strncpy(key.plate, plate.c_str(), sizeof(key.plate) - 1);
+    return true;
+}
+
+void SectionControl::entryRead(const std::string &plate, const std::string &section, double timestamp) {
+    std::lock_guard<std::mutex> lock(mtx);
+    JoinKey key;
+    if (!makeKey(plate, section, key)) return;
+
+    evictLocked(timestamp);
+    stats.entryReads++;
+
+    // A later entry read for the same plate replaces the earlier one; the
+    // earlier expiry is then recognised as stale by its entry time
+    entries[key] = timestamp;
+    expiries.push_back({timestamp + window, key, timestamp});
+
+    stats.joinState = entries.size();
+    if (stats.joinState > stats.peakJoinState) {
+        stats.peakJoinState = stats.joinState;
+    }
+}
+
+bool SectionControl::exitRead(const std::string &plate, const std::string &section, double timestamp,
+                              SectionPassage &passage) {
+    std::lock_guard<std::mutex> lock(mtx);
+    JoinKey key;
+    if (!makeKey(plate, section, key)) return false;
+
+    evictLocked(timestamp);
+    stats.exitReads++;
+
+    auto it = entries.find(key);
+    if (it == entries.end() || timestamp <= it->second) {
+        stats.unmatchedExits++;
+        return false;
+    }
+
+    passage.plate = plate;
+    passage.section = section;
+    passage.entryTime = it->second;
+    passage.exitTime = timestamp;
+    passage.averageSpeed = static_cast<float>(sectionLengths[key.section] / (timestamp - it->second));
+
+    // The expiry record stays queued and is skipped as stale when it comes due
+    entries.erase(it);
+    stats.matched++;
+    stats.joinState = entries.size();
+    return true;
+}
+
+void SectionControl::evictLocked(double now) {
+    while (!expiries.empty() && expiries.front().expiresAt <= now) {
+        const Expiry &expiry = expiries.front();
+        auto it = entries.find(expiry.key);
+        if (it != entries.end() && it->second == expiry.entryTime) {
+            entries.erase(it);
+            stats.evicted++;
+        }
+        expiries.pop_front();
+    }
+    stats.joinState = entries.size();
+}
+
+void SectionControl::evict(double now) {
+    std::lock_guard<std::mutex> lock(mtx);
+    evictLocked(now);
+}
+
+SectionControlStats SectionControl::getStats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return stats;
+}
@@ -0,0 +1,92 @@
+// SectionControl.h
+
+#ifndef SECTION_CONTROL_H
+#define SECTION_CONTROL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const size_t SECTION_PLATE_CHARS = 32; // as ViolationMsg::vehicleID; longer plates are cut
+// Memory set aside for the join state before it falls back to the heap: at the
+// default 120 s window a busy intersection keeps well under a thousand reads
+static const size_t SECTION_CONTROL_RESERVED_BYTES = 256 * 1024;
+static const size_t SECTION_CONTROL_RESERVED_READS = 1024;
+
+// Entry read matched with its exit read
+struct SectionPassage {
+    std::string plate;
+    std::string section;
+    double entryTime;
+    double exitTime;
+    float averageSpeed; // section length / elapsed time, in pixels per second
+};
+
+struct SectionControlStats {
+    long long entryReads = 0;
+    long long exitReads = 0;
+    long long matched = 0;
+    long long unmatchedExits = 0;
+    long long evicted = 0;
+    size_t joinState = 0;
+    size_t peakJoinState = 0;
+};
+
+// Average-speed enforcement over camera-to-camera sections.
+// Entry reads are kept in a hash table keyed by section and plate until the
+// matching exit read arrives (a streaming hash join). Reads arrive in time
+// order and share one window, so a FIFO of expiry times is enough to evict
+// everything older than the window and keep the join state bounded.
+// Keys are fixed-width and the table and FIFO draw from a pool over a reserved
+// buffer, so reads made inside a simulation step do not touch the heap.
+class SectionControl {
+private:
+    struct JoinKey {
+        uint32_t section;                // index into sectionLengths
+        char plate[SECTION_PLATE_CHARS]; // NUL-padded
+        bool operator==(const JoinKey &other) const;
+    };
+    struct JoinKeyHash {
+        size_t operator()(const JoinKey &key) const;
+    };
+    struct Expiry {
+        double expiresAt;
+        JoinKey key;
+        double entryTime;
+    };
+
+    std::map<std::string, uint32_t> sectionIds;
+    std::vector<float> sectionLengths; // pixels between the entry and exit cameras
+    double window; // seconds an entry read waits for its exit read
+    std::vector<std::byte> reserved;
+    std::pmr::monotonic_buffer_resource reservedArena;
+    std::pmr::unsynchronized_pool_resource pool; // recycles the nodes freed by matches and evictions
+    std::pmr::unordered_map<JoinKey, double, JoinKeyHash> entries; // entry time
+    std::pmr::deque<Expiry> expiries;
+    SectionControlStats stats;
+    std::mutex mtx; // Mutex for thread safety
+
+    void evictLocked(double now);
+    // False when the section is unknown
+    bool makeKey(const std::string &plate, const std::string &section, JoinKey &key) const;
+
+public:
+    explicit SectionControl(double window);
+    void addSection(const std::string &section, float length);
+
+    void entryRead(const std::string &plate, const std::string &section, double timestamp);
+    // Returns true and fills `passage` when the exit read matches a live entry read
+    bool exitRead(const std::string &plate, const std::string &section, double timestamp, SectionPassage &passage);
+    // Drops entry reads whose window has passed
+    void evict(double now);
+
+    SectionControlStats getStats();
+};
+
+#endif // SECTION_CONTROL_H
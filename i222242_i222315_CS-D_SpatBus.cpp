@@ -0,0 +1,43 @@
+// SpatBus.cpp
+
+#include "SpatBus.h"
+#include <algorithm>
+#include <chrono>
+
+int spatApproachIndex(const std::string &approach) {
+    if (approach == "North") return SPAT_NORTH;
+    if (approach == "South") return SPAT_SOUTH;
+    if (approach == "East") return SPAT_EAST;
+    if (approach == "West") return SPAT_WEST;
+    return -1;
+}
+
+double spatMinTimeToChange(const SpatMessage &msg, double now) {
+    return std::max(0.0, msg.minEndTime - now);
+}
+
+double spatMaxTimeToChange(const SpatMessage &msg, double now) {
+    return std::max(0.0, msg.maxEndTime - now);
+}
+
+SpatBus::SpatBus() : sequence(0) {}
+
+void SpatBus::publish(const SpatMessage &msg) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<SpatMessage> buffer = std::make_shared<SpatMessage>(msg);
+    buffer->sequence = ++sequence;
+    std::atomic_store(&latest, std::shared_ptr<const SpatMessage>(buffer));
+    changed.notify_all();
+}
+
+std::shared_ptr<const SpatMessage> SpatBus::current() const {
+    return std::atomic_load(&latest);
+}
+
+std::shared_ptr<const SpatMessage> SpatBus::waitNewer(unsigned long seenSequence, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (!changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&] { return sequence > seenSequence; })) {
+        return nullptr;
+    }
+    return latest;
+}
@@ -0,0 +1,51 @@
+// SpatBus.h
+
+#ifndef SPAT_BUS_H
+#define SPAT_BUS_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+enum SpatApproach { SPAT_NORTH, SPAT_SOUTH, SPAT_EAST, SPAT_WEST, NUM_SPAT_APPROACHES };
+
+// Index of an approach ("North", "South", "East", "West") in SpatMessage::state, or -1
+int spatApproachIndex(const std::string &approach);
+
+// Signal phase and timing, published by the controller once per change.
+// Plain data, so it can be put on the wire as it is.
+struct SpatMessage {
+    unsigned long sequence;         // stamped by the bus, increases with every publish
+    double publishedAt;             // seconds since the epoch
+    int phase;                      // controller phase being served
+    int state[NUM_SPAT_APPROACHES]; // light state of each approach
+    double minEndTime;              // earliest the states can change, seconds since the epoch
+    double maxEndTime;              // latest they will change
+};
+
+// Seconds until the earliest and latest possible change, clamped at zero
+double spatMinTimeToChange(const SpatMessage &msg, double now);
+double spatMaxTimeToChange(const SpatMessage &msg, double now);
+
+// Publish/subscribe bus for SPaT.
+// Each message is written once into an immutable shared buffer and every
+// subscriber reads that same buffer: nothing is copied per reader and readers
+// never take a lock. Subscribers that react to changes wait on the sequence.
+class SpatBus {
+private:
+    std::shared_ptr<const SpatMessage> latest;
+    unsigned long sequence;
+    std::mutex mtx; // Mutex for publishers and waiters
+    std::condition_variable changed;
+
+public:
+    SpatBus();
+    void publish(const SpatMessage &msg);
+    // Latest message, null before the first publish
+    std::shared_ptr<const SpatMessage> current() const;
+    // Waits up to timeoutMs for a message newer than `seenSequence`; null on timeout
+    std::shared_ptr<const SpatMessage> waitNewer(unsigned long seenSequence, int timeoutMs);
+};
+
+#endif // SPAT_BUS_H
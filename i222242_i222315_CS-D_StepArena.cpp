@@ -0,0 +1,81 @@
+// StepArena.cpp
+
+#include "StepArena.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#ifdef STEP_ALLOC_COUNT
+static thread_local unsigned long long heapAllocations = 0;
+
+// Counting replacement for the global allocator; array, nothrow and sized forms
+// all come through these
+void *operator new(std::size_t size) {
+    heapAllocations++;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+unsigned long long threadHeapAllocations() {
+    return heapAllocations;
+}
+#else
+unsigned long long threadHeapAllocations() {
+    return 0;
+}
+#endif
+
+void *StepArena::Upstream::do_allocate(size_t size, size_t alignment) {
+    bytes += size;
+    return std::pmr::new_delete_resource()->allocate(size, alignment);
+}
+
+void StepArena::Upstream::do_deallocate(void *p, size_t size, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+}
+
+StepArena::StepArena(size_t initialBytes) : buffer(initialBytes) {
+    arena.emplace(buffer.data(), buffer.size(), &upstream);
+    stats.capacity = buffer.size();
+}
+
+void *StepArena::do_allocate(size_t size, size_t alignment) {
+    stepBytes += size;
+    return arena->allocate(size, alignment);
+}
+
+void StepArena::beginStep() {
+    if (upstream.bytes > 0) {
+        // The last step overflowed: take its chunks back and grow so the next one fits
+        arena.reset();
+        buffer = std::vector<std::byte>(std::max(buffer.size() * 2, stepBytes * 2));
+        arena.emplace(buffer.data(), buffer.size(), &upstream);
+        upstream.bytes = 0;
+        stats.capacity = buffer.size();
+    } else {
+        arena->release();
+    }
+    stepBytes = 0;
+    heapAtStepStart = threadHeapAllocations();
+}
+
+void StepArena::endStep() {
+    stats.steps++;
+    stats.lastStepBytes = stepBytes;
+    stats.peakStepBytes = std::max(stats.peakStepBytes, stepBytes);
+    if (upstream.bytes > 0) stats.overflows++;
+    stats.lastStepHeapAllocations = threadHeapAllocations() - heapAtStepStart;
+    if (stats.steps == 1) {
+        stats.firstStepHeapAllocations = stats.lastStepHeapAllocations;
+    } else {
+        stats.peakStepHeapAllocations = std::max(stats.peakStepHeapAllocations, stats.lastStepHeapAllocations);
+    }
+}
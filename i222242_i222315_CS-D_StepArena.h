@@ -0,0 +1,68 @@
+// StepArena.h
+
+#ifndef STEP_ARENA_H
+#define STEP_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+// Heap allocations made by the calling thread so far. Counting replaces the global
+// operator new, so it is a debug build option (make STEP_ALLOC_COUNT=1); otherwise
+// the count stays 0.
+#ifdef STEP_ALLOC_COUNT
+static const bool HEAP_ALLOCATIONS_COUNTED = true;
+#else
+static const bool HEAP_ALLOCATIONS_COUNTED = false;
+#endif
+unsigned long long threadHeapAllocations();
+
+struct StepArenaStats {
+    size_t capacity = 0;       // bytes in the arena's own buffer
+    size_t lastStepBytes = 0;  // bytes handed out during the last step
+    size_t peakStepBytes = 0;
+    long long steps = 0;
+    long long overflows = 0;   // steps that outgrew the buffer and borrowed from the heap
+    unsigned long long lastStepHeapAllocations = 0; // on this thread, inside and outside the arena
+    unsigned long long peakStepHeapAllocations = 0;  // from the second step on
+    unsigned long long firstStepHeapAllocations = 0; // the first step also builds the reused step buffers
+};
+
+// Monotonic arena for data that lives for one simulation step. Allocation is a
+// pointer bump and deallocation a no-op; beginStep() takes everything back at once.
+// A step that outgrows the buffer borrows from the heap and the buffer is enlarged
+// before the next one, so in steady state a step makes no heap allocations at all.
+// Containers using the arena must not outlive the step. Not thread-safe.
+class StepArena : public std::pmr::memory_resource {
+private:
+    // Heap behind the arena; whatever it hands out is an overflow
+    class Upstream : public std::pmr::memory_resource {
+    public:
+        size_t bytes = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+    };
+
+    std::vector<std::byte> buffer;
+    Upstream upstream;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+    size_t stepBytes = 0;
+    unsigned long long heapAtStepStart = 0;
+    StepArenaStats stats;
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+public:
+    explicit StepArena(size_t initialBytes);
+    void beginStep();
+    void endStep();
+    StepArenaStats getStats() const { return stats; }
+};
+
+#endif // STEP_ARENA_H
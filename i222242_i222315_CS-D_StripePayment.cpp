@@ -0,0 +1,88 @@
+// StripePayment.cpp
+// Payment processor, spawned by the simulation: smarttraffix-stripe
+
+#include "common.h"
+#include <fcntl.h>
+#include <mqueue.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main() {
+    installChildSignalHandlers();
+
+    // Open the message queue to receive payment messages
+    mqd_t mqStripeToChallanLocal = mq_open(MQ_STRIPE_TO_CHALLAN, O_RDONLY | O_NONBLOCK);
+    if (mqStripeToChallanLocal == (mqd_t)-1) {
+        std::cerr << "[StripePayment] Failed to open MQ_STRIPE_TO_CHALLAN: " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // Open the message queue to send challan updates. Only the portal reads it, and only
+    // while a user is at the menu, so the send must never hold up a payment.
+    mqd_t mqChallanToSmartLocal = mq_open(MQ_CHALLAN_TO_SMART, O_WRONLY | O_NONBLOCK);
+    if (mqChallanToSmartLocal == (mqd_t)-1) {
+        std::cerr << "[StripePayment] Failed to open MQ_CHALLAN_TO_SMART: " << strerror(errno) << std::endl;
+        mq_close(mqStripeToChallanLocal);
+        return 1;
+    }
+
+    // Settled payments are also reported to the simulation, which counts them for the
+    // overlay and forwards them to the challan worker holding the plate's ledger.
+    mqd_t mqStripeToSmartLocal = mq_open(MQ_STRIPE_TO_SMART, O_WRONLY | O_NONBLOCK);
+    if (mqStripeToSmartLocal == (mqd_t)-1) {
+        std::cerr << "[StripePayment] Failed to open MQ_STRIPE_TO_SMART: " << strerror(errno) << std::endl;
+    }
+
+    unsigned long updatesDropped = 0; // challan updates the portal was not there to read
+
+    while (childRunning) {
+        char buffer[MQ_MAX_SIZE]; // mq_receive needs room for the queue's full message size
+        ssize_t bytesRead = mq_receive(mqStripeToChallanLocal, buffer, sizeof(buffer), NULL);
+        if (bytesRead >= 0) {
+            PaymentMsg *msg = reinterpret_cast<PaymentMsg*>(buffer);
+            std::string vehicleID(msg->vehicleID);
+            bool paid = msg->paid;
+
+            // Update challan status
+            ChallanUpdateMsg challanMsg;
+            std::strncpy(challanMsg.vehicleID, vehicleID.c_str(), sizeof(challanMsg.vehicleID) - 1);
+            challanMsg.vehicleID[sizeof(challanMsg.vehicleID) - 1] = '\0';
+            challanMsg.paid = paid;
+
+            // The payment stands whether or not the portal hears of it; a full queue
+            // only drops the notification
+            if (paid) {
+                std::cout << "[StripePayment] Vehicle " << vehicleID << " has paid the challan.";
+                if (mqStripeToSmartLocal != (mqd_t)-1 &&
+                    mq_send(mqStripeToSmartLocal, reinterpret_cast<const char*>(msg), sizeof(PaymentMsg), 0) == -1) {
+                    std::cerr << "[StripePayment] Failed to report payment: " << strerror(errno) << std::endl;
+                }
+            } else {
+                std::cout << "[StripePayment] Vehicle " << vehicleID << " challan payment failed.";
+            }
+            if (mq_send(mqChallanToSmartLocal, reinterpret_cast<const char*>(&challanMsg), sizeof(challanMsg), 0) == -1) {
+                if (errno == EAGAIN) {
+                    std::cout << " (portal queue full, " << ++updatesDropped << " updates dropped)";
+                } else if (errno != EINTR) {
+                    std::cerr << "[StripePayment] Failed to send challan update: " << strerror(errno) << std::endl;
+                }
+            }
+            std::cout << std::endl;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "[StripePayment] Failed to receive message: " << strerror(errno) << std::endl;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+    }
+
+    // Close message queues
+    mq_close(mqStripeToChallanLocal);
+    mq_close(mqChallanToSmartLocal);
+    if (mqStripeToSmartLocal != (mqd_t)-1) mq_close(mqStripeToSmartLocal);
+    return 0;
+}
@@ -0,0 +1,304 @@
+// Supervisor.cpp
+
+#include "Supervisor.h"
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+extern char **environ;
+
+// A worker that dies more often than this within one second is not restarted again
+static const int MAX_RESTARTS_PER_SECOND = 5;
+// A restart whose spawn fails is retried after 100 ms, doubling each time, and
+// abandoned after this many attempts (about 3 s in all)
+static const int SPAWN_RETRY_INITIAL_MS = 100;
+static const int MAX_SPAWN_ATTEMPTS = 6;
+
+// Returns a pidfd for the child, or -1 when the kernel does not support pidfds
+static int openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+Supervisor::Supervisor()
+    : supervising(false), sigFd(-1), wakeFd(-1), totalRestartLatencyMs(0.0) {
+    sigemptyset(&oldMask);
+}
+
+Supervisor::~Supervisor() {
+    stopAll();
+    if (sigFd != -1) close(sigFd);
+    if (wakeFd != -1) close(wakeFd);
+}
+
+int Supervisor::addChild(const std::string &name, std::vector<std::string> argv) {
+    std::lock_guard<std::mutex> lock(mtx);
+    Child child;
+    child.name = name;
+    child.argv = std::move(argv);
+    children.push_back(child);
+    return static_cast<int>(children.size()) - 1;
+}
+
+void Supervisor::setShutdownHandler(std::function<void(int)> handler) {
+    std::lock_guard<std::mutex> lock(mtx);
+    onShutdownSignal = std::move(handler);
+}
+
+// The worker is a separate, small executable: nothing of this process's
+// address space, SFML state or threads is carried into it
+bool Supervisor::spawn(Child &child) {
+    std::vector<char *> argv;
+    for (auto &arg : child.argv) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    // The child starts with the signal mask we had before start() blocked the
+    // supervised signals, and with SIGTERM/SIGCHLD at their defaults
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGTERM);
+    sigaddset(&defaults, SIGCHLD);
+    posix_spawnattr_setsigmask(&attr, &oldMask);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    pid_t pid = -1;
+    int rc = posix_spawn(&pid, argv[0], nullptr, &attr, argv.data(), environ);
+    posix_spawnattr_destroy(&attr);
+    if (rc != 0) {
+        std::cerr << "[Supervisor] Failed to spawn " << child.name << " (" << child.argv[0] << "): "
+                  << strerror(rc) << std::endl;
+        return false;
+    }
+
+    child.pid = pid;
+    child.pidfd = openPidfd(pid);
+    return true;
+}
+
+bool Supervisor::start() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    if (pthread_sigmask(SIG_BLOCK, &mask, &oldMask) != 0) {
+        perror("pthread_sigmask");
+        return false;
+    }
+
+    sigFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sigFd == -1 || wakeFd == -1) {
+        perror("signalfd/eventfd");
+        return false;
+    }
+
+    supervising = true;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto &child : children) {
+            if (!spawn(child)) {
+                return false;
+            }
+        }
+    }
+
+    monitor = std::thread(&Supervisor::monitorLoop, this);
+    return true;
+}
+
+void Supervisor::handleExit(Child &child, int status, std::chrono::steady_clock::time_point seenAt) {
+    if (child.pidfd != -1) {
+        close(child.pidfd);
+        child.pidfd = -1;
+    }
+    child.pid = -1;
+
+    // A clean exit (e.g. the user leaving the portal) is not a failure
+    bool failed = WIFSIGNALED(status) || (WIFEXITED(status) && WEXITSTATUS(status) != 0);
+    if (!failed || !supervising || child.givenUp) {
+        return;
+    }
+
+    if (seenAt - child.windowStart > std::chrono::seconds(1)) {
+        child.windowStart = seenAt;
+        child.restartsInWindow = 0;
+    }
+    if (++child.restartsInWindow > MAX_RESTARTS_PER_SECOND) {
+        giveUp(child, "is crash looping");
+        return;
+    }
+
+    child.exitSeenAt = seenAt;
+    child.spawnAttempts = 0;
+    respawn(child);
+}
+
+void Supervisor::respawn(Child &child) {
+    child.spawnAttempts++;
+    if (!spawn(child)) {
+        stats.failedSpawns++;
+        if (child.spawnAttempts >= MAX_SPAWN_ATTEMPTS) {
+            giveUp(child, "could not be spawned again");
+            return;
+        }
+        int delayMs = SPAWN_RETRY_INITIAL_MS << (child.spawnAttempts - 1);
+        child.respawnPending = true;
+        child.retryAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+        std::cerr << "[Supervisor] Retrying " << child.name << " in " << delayMs << " ms." << std::endl;
+        return;
+    }
+    child.respawnPending = false;
+
+    double latencyMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - child.exitSeenAt).count();
+    child.restarts++;
+    stats.totalRestarts++;
+    stats.lastRestartLatencyMs = latencyMs;
+    if (latencyMs > stats.maxRestartLatencyMs) {
+        stats.maxRestartLatencyMs = latencyMs;
+    }
+    totalRestartLatencyMs += latencyMs;
+    stats.avgRestartLatencyMs = totalRestartLatencyMs / stats.totalRestarts;
+
+    std::cerr << "[Supervisor] Restarted " << child.name << " (pid " << child.pid << ") in "
+              << latencyMs << " ms." << std::endl;
+}
+
+// The worker stays down; the owner sees it in getStats().workersGivenUp
+void Supervisor::giveUp(Child &child, const char *reason) {
+    std::cerr << "[Supervisor] " << child.name << " " << reason << "; giving up." << std::endl;
+    child.givenUp = true;
+    child.respawnPending = false;
+    stats.workersGivenUp++;
+}
+
+// Milliseconds until the earliest pending spawn retry, or -1 when none is pending
+int Supervisor::nextRetryTimeoutMs() {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto now = std::chrono::steady_clock::now();
+    int timeoutMs = -1;
+    for (const auto &child : children) {
+        if (!child.respawnPending) continue;
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(child.retryAt - now).count();
+        int ms = static_cast<int>(std::max<long long>(0, wait));
+        if (timeoutMs == -1 || ms < timeoutMs) timeoutMs = ms;
+    }
+    return timeoutMs;
+}
+
+void Supervisor::monitorLoop() {
+    while (supervising) {
+        std::vector<pollfd> fds;
+        fds.push_back({wakeFd, POLLIN, 0});
+        fds.push_back({sigFd, POLLIN, 0});
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (const auto &child : children) {
+                if (child.pidfd != -1) {
+                    fds.push_back({child.pidfd, POLLIN, 0});
+                }
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), nextRetryTimeoutMs()) == -1) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+        // Restart latency is measured from here, where a dead worker's pidfd was seen readable
+        auto seenAt = std::chrono::steady_clock::now();
+        if (!supervising) break;
+
+        // Drain the signalfd; SIGCHLD only wakes us, the reaping below is per child
+        int shutdownSignal = 0;
+        signalfd_siginfo info;
+        while (read(sigFd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+            if (info.ssi_signo == SIGINT || info.ssi_signo == SIGTERM) {
+                shutdownSignal = static_cast<int>(info.ssi_signo);
+            }
+        }
+
+        if (shutdownSignal != 0) {
+            std::function<void(int)> handler;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                handler = onShutdownSignal;
+            }
+            if (handler) {
+                handler(shutdownSignal);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto &child : children) {
+            if (child.pid <= 0) continue;
+            int status = 0;
+            if (waitpid(child.pid, &status, WNOHANG) == child.pid) {
+                handleExit(child, status, seenAt);
+            }
+        }
+        for (auto &child : children) {
+            if (child.respawnPending && !child.givenUp && std::chrono::steady_clock::now() >= child.retryAt) {
+                respawn(child);
+            }
+        }
+    }
+}
+
+void Supervisor::stopAll() {
+    supervising = false;
+    if (wakeFd != -1) {
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) == -1) {
+            perror("write wakeFd");
+        }
+    }
+
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto &child : children) {
+        if (child.pid > 0) kill(child.pid, SIGTERM);
+    }
+    for (auto &child : children) {
+        if (child.pid > 0) waitpid(child.pid, NULL, 0);
+        if (child.pidfd != -1) close(child.pidfd);
+        child.pid = -1;
+        child.pidfd = -1;
+    }
+}
+
+pid_t Supervisor::getPid(int child) {
+    std::lock_guard<std::mutex> lock(mtx);
+    return children[child].pid;
+}
+
+SupervisorStats Supervisor::getStats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return stats;
+}
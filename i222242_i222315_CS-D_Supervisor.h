@@ -0,0 +1,88 @@
+// Supervisor.h
+
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <sys/types.h>
+#include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Restart statistics reported by the supervisor
+struct SupervisorStats {
+    int totalRestarts = 0;
+    int failedSpawns = 0;   // restarts whose posix_spawn failed and was retried
+    int workersGivenUp = 0; // crash looping, or still failing to spawn after every retry
+    // From poll() seeing the worker's exit to its replacement being spawned, retries included
+    double lastRestartLatencyMs = 0.0;
+    double maxRestartLatencyMs = 0.0;
+    double avgRestartLatencyMs = 0.0;
+};
+
+// Starts worker executables with posix_spawn, watches them through pidfds (with a signalfd for
+// SIGCHLD as fallback) and restarts any worker that dies abnormally. A restart whose
+// spawn fails is retried with backoff.
+// SIGINT/SIGTERM are also read from the signalfd, outside any async signal handler,
+// and passed to the shutdown handler; the program itself shuts down on its main thread.
+class Supervisor {
+private:
+    struct Child {
+        std::string name;
+        std::vector<std::string> argv; // argv[0] is the executable's path
+        pid_t pid = -1;
+        int pidfd = -1;
+        int restarts = 0;
+        bool givenUp = false;
+        std::chrono::steady_clock::time_point windowStart;
+        int restartsInWindow = 0;
+        // Set while a restart waits for a retry of its failed spawn
+        bool respawnPending = false;
+        int spawnAttempts = 0;
+        std::chrono::steady_clock::time_point exitSeenAt;
+        std::chrono::steady_clock::time_point retryAt;
+    };
+
+    std::vector<Child> children;
+    std::mutex mtx;
+    std::thread monitor;
+    std::atomic<bool> supervising;
+    int sigFd;
+    int wakeFd;
+    sigset_t oldMask;
+    std::function<void(int)> onShutdownSignal;
+    SupervisorStats stats;
+    double totalRestartLatencyMs;
+
+    bool spawn(Child &child);
+    void handleExit(Child &child, int status, std::chrono::steady_clock::time_point seenAt);
+    void respawn(Child &child);
+    void giveUp(Child &child, const char *reason);
+    int nextRetryTimeoutMs();
+    void monitorLoop();
+
+public:
+    Supervisor();
+    ~Supervisor();
+
+    // Registers a worker executable and its arguments; must be called before start()
+    int addChild(const std::string &name, std::vector<std::string> argv);
+    // Called with the signal number when SIGINT or SIGTERM is received. It runs on the
+    // monitor thread, so it should only ask the program to stop (e.g. clear a flag
+    // its main loop polls); stopAll() and any cleanup belong on the main thread.
+    void setShutdownHandler(std::function<void(int)> handler);
+    // Blocks SIGCHLD/SIGINT/SIGTERM for the calling thread (and every thread
+    // it creates afterwards), spawns all workers and starts monitoring
+    bool start();
+    // Stops monitoring, terminates every worker and reaps it
+    void stopAll();
+
+    pid_t getPid(int child);
+    SupervisorStats getStats();
+};
+
+#endif // SUPERVISOR_H
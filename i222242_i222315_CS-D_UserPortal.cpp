@@ -0,0 +1,157 @@
+// UserPortal.cpp
+// Interactive challan portal, spawned by the simulation: smarttraffix-portal
+
+#include "common.h"
+#include <fcntl.h>
+#include <mqueue.h>
+#include <semaphore.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+// Sends "active" or "inactive" to the simulation, which mutes its output while the portal is open
+static void sendPortalStatus(mqd_t mqPortalStatus, const char *status) {
+    PortalStatusMsg msg;
+    std::strncpy(msg.status, status, sizeof(msg.status) - 1);
+    msg.status[sizeof(msg.status) - 1] = '\0';
+    if (mq_send(mqPortalStatus, reinterpret_cast<const char*>(&msg), sizeof(msg), 0) == -1) {
+        std::cerr << "UserPortal: Failed to send '" << status << "' status." << std::endl;
+    }
+}
+
+int main() {
+    installChildSignalHandlers();
+    std::map<std::string, bool> activeChallans; // vehicleID -> challanActive
+
+    // Open the portal status message queue for writing
+    mqd_t mqPortalStatus = mq_open(MQ_PORTAL_STATUS, O_WRONLY);
+    if (mqPortalStatus == (mqd_t)-1) {
+        std::cerr << "UserPortal: Failed to open portal status message queue." << std::endl;
+        return 1;
+    }
+
+    // Open the message queue to receive challan updates
+    mqd_t mqChallanToSmartLocal = mq_open(MQ_CHALLAN_TO_SMART, O_RDONLY | O_NONBLOCK);
+    if (mqChallanToSmartLocal == (mqd_t)-1) {
+        std::cerr << "UserPortal: Failed to open MQ_CHALLAN_TO_SMART." << std::endl;
+        mq_close(mqPortalStatus);
+        return 1;
+    }
+
+    // Open the message queue to send payment messages
+    mqd_t mqStripeToChallanLocal = mq_open(MQ_STRIPE_TO_CHALLAN, O_WRONLY);
+    if (mqStripeToChallanLocal == (mqd_t)-1) {
+        std::cerr << "UserPortal: Failed to open MQ_STRIPE_TO_CHALLAN." << std::endl;
+        mq_close(mqPortalStatus);
+        mq_close(mqChallanToSmartLocal);
+        return 1;
+    }
+
+    // The simulation's semaphore over the active vehicles, taken while listing challans
+    sem_t *activeVehiclesSem = sem_open(SEM_ACTIVE_VEHICLES, 0);
+    if (activeVehiclesSem == SEM_FAILED) {
+        perror("UserPortal: sem_open activeVehiclesSem");
+    }
+
+    // Send 'active' status before opening the portal
+    sendPortalStatus(mqPortalStatus, "active");
+
+    // User interaction loop
+    while (childRunning) {
+        std::cout << "\n--- User Portal ---\n";
+        std::cout << "1. View Challans\n2. Pay Challan\n3. Exit\nEnter choice: ";
+        int choice;
+        std::cin >> choice;
+
+        if (!childRunning || !std::cin) break;
+
+        if (choice == 1) {
+            std::cout << "\n--- Active Challans ---\n";
+            if (activeVehiclesSem != SEM_FAILED && sem_wait(activeVehiclesSem) == -1) {
+                perror("UserPortal: sem_wait activeVehiclesSem");
+                continue;
+            }
+
+            bool hasChallans = false;
+            for (const auto &entry : activeChallans) {
+                if (entry.second) { // If challan is active
+                    std::cout << "Vehicle ID: " << entry.first << " | Paid: No\n";
+                    hasChallans = true;
+                }
+            }
+
+            if (!hasChallans) {
+                std::cout << "No active challans.\n";
+            }
+
+            if (activeVehiclesSem != SEM_FAILED && sem_post(activeVehiclesSem) == -1) {
+                perror("UserPortal: sem_post activeVehiclesSem");
+            }
+        }
+        else if (choice == 2) {
+            std::cout << "Enter Vehicle ID to pay challan: ";
+            std::string vid;
+            std::cin >> vid;
+
+            // Check if challan exists
+            auto challan = activeChallans.find(vid);
+            if (challan != activeChallans.end() && challan->second) {
+                // Create payment message
+                PaymentMsg paymentMsg;
+                std::strncpy(paymentMsg.vehicleID, vid.c_str(), sizeof(paymentMsg.vehicleID) - 1);
+                paymentMsg.vehicleID[sizeof(paymentMsg.vehicleID) - 1] = '\0';
+                paymentMsg.paid = true;
+
+                // Send payment message to StripePayment
+                if (mq_send(mqStripeToChallanLocal, reinterpret_cast<const char*>(&paymentMsg), sizeof(paymentMsg), 0) == -1) {
+                    std::cerr << "UserPortal: Failed to send payment message." << std::endl;
+                } else {
+                    std::cout << "Challan for Vehicle ID " << vid << " has been submitted for payment.\n";
+                }
+            } else {
+                std::cout << "No active challan found for Vehicle ID " << vid << ".\n";
+            }
+        }
+        else if (choice == 3) {
+            std::cout << "Exiting User Portal.\n";
+            break;
+        }
+        else {
+            std::cout << "Invalid choice. Try again.\n";
+        }
+
+        // Process every challan update that arrived since the last choice; the workers
+        // drop updates rather than wait while the queue is full
+        char buffer[MQ_MAX_SIZE]; // mq_receive needs room for the queue's full message size
+        while (mq_receive(mqChallanToSmartLocal, buffer, sizeof(buffer), NULL) >= 0) {
+            ChallanUpdateMsg *msg = reinterpret_cast<ChallanUpdateMsg*>(buffer);
+            std::string vehicleID(msg->vehicleID);
+
+            if (msg->paid) {
+                // Update challan status
+                activeChallans[vehicleID] = false;
+                std::cout << "[UserPortal] Challan for Vehicle " << vehicleID << " has been paid.\n";
+            } else {
+                activeChallans[vehicleID] = true;
+                std::cout << "[UserPortal] Challan issued to Vehicle " << vehicleID << ".\n";
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+
+    // Send 'inactive' status after closing the portal
+    sendPortalStatus(mqPortalStatus, "inactive");
+
+    // Close message queues
+    if (activeVehiclesSem != SEM_FAILED) sem_close(activeVehiclesSem);
+    mq_close(mqPortalStatus);
+    mq_close(mqChallanToSmartLocal);
+    mq_close(mqStripeToChallanLocal);
+    return 0;
+}
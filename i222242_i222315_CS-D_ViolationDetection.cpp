@@ -0,0 +1,61 @@
+// ViolationDetection.cpp
+
+#include "ViolationDetection.h"
+#include <algorithm>
+#include <cmath>
+
+StopLine makeStopLine(float entryX, float entryY, float dirX, float dirY, float distance, float halfWidth) {
+    float cx = entryX + dirX * distance;
+    float cy = entryY + dirY * distance;
+    // Perpendicular to the direction of travel
+    float nx = -dirY, ny = dirX;
+    return {cx - nx * halfWidth, cy - ny * halfWidth, cx + nx * halfWidth, cy + ny * halfWidth};
+}
+
+void CrossingBatch::clear() {
+    fromX.clear(); fromY.clear(); toX.clear(); toY.clear();
+    lineX0.clear(); lineY0.clear(); lineX1.clear(); lineY1.clear();
+}
+
+void CrossingBatch::reserve(size_t n) {
+    fromX.reserve(n); fromY.reserve(n); toX.reserve(n); toY.reserve(n);
+    lineX0.reserve(n); lineY0.reserve(n); lineX1.reserve(n); lineY1.reserve(n);
+}
+
+void CrossingBatch::add(float x0, float y0, float x1, float y1, const StopLine &line) {
+    fromX.push_back(x0); fromY.push_back(y0);
+    toX.push_back(x1); toY.push_back(y1);
+    lineX0.push_back(line.x0); lineY0.push_back(line.y0);
+    lineX1.push_back(line.x1); lineY1.push_back(line.y1);
+}
+
+void sweptStopLineCrossings(const CrossingBatch &batch, std::vector<float> &fraction) {
+    const size_t n = batch.size();
+    fraction.resize(n);
+
+    const float *px = batch.fromX.data(), *py = batch.fromY.data();
+    const float *ex = batch.toX.data(), *ey = batch.toY.data();
+    const float *ax = batch.lineX0.data(), *ay = batch.lineY0.data();
+    const float *bx = batch.lineX1.data(), *by = batch.lineY1.data();
+    float *out = fraction.data();
+
+    for (size_t i = 0; i < n; ++i) {
+        // Solve from + t * r == lineStart + u * s
+        float rx = ex[i] - px[i], ry = ey[i] - py[i];
+        float sx = bx[i] - ax[i], sy = by[i] - ay[i];
+        float qx = ax[i] - px[i], qy = ay[i] - py[i];
+        float denom = rx * sy - ry * sx;
+        float tNum = qx * sy - qy * sx;
+        float uNum = qx * ry - qy * rx;
+
+        // Range tests on the numerators with the sign of denom folded in, so the
+        // loop has no division by zero to guard and no branches
+        float sign = std::copysign(1.f, denom);
+        float absDenom = std::fabs(denom);
+        float tScaled = tNum * sign, uScaled = uNum * sign;
+        float hit = static_cast<float>((absDenom > 0.f) & (tScaled > 0.f) & (tScaled <= absDenom) &
+                                       (uScaled >= 0.f) & (uScaled <= absDenom));
+        float t = tScaled / std::max(absDenom, 1e-30f);
+        out[i] = hit * t + (hit - 1.f); // t on a hit, -1 otherwise
+    }
+}
@@ -0,0 +1,35 @@
+// ViolationDetection.h
+
+#ifndef VIOLATION_DETECTION_H
+#define VIOLATION_DETECTION_H
+
+#include <cstddef>
+#include <vector>
+
+// Stop line drawn across a lane, as a segment from (x0, y0) to (x1, y1)
+struct StopLine {
+    float x0, y0, x1, y1;
+};
+
+// Builds the stop line `distance` pixels down a lane, `halfWidth` to each side of its centre
+StopLine makeStopLine(float entryX, float entryY, float dirX, float dirY, float distance, float halfWidth);
+
+// One simulation step of vehicle motion in structure-of-arrays form, with the
+// stop line of each vehicle's lane gathered alongside it
+struct CrossingBatch {
+    std::vector<float> fromX, fromY, toX, toY;
+    std::vector<float> lineX0, lineY0, lineX1, lineY1;
+
+    void clear();
+    void reserve(size_t n);
+    void add(float x0, float y0, float x1, float y1, const StopLine &line);
+    size_t size() const { return fromX.size(); }
+};
+
+// Swept segment test of every vehicle's step against its stop line.
+// fraction[i] is where along the step vehicle i crossed (0..1], or -1 if it did not;
+// a step ending exactly on the line counts, the next one starting there does not.
+// The loop is branch-free so the compiler can vectorize it.
+void sweptStopLineCrossings(const CrossingBatch &batch, std::vector<float> &fraction);
+
+#endif // VIOLATION_DETECTION_H
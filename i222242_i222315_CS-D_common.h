@@ -3,22 +3,87 @@
 #ifndef COMMON_H
 #define COMMON_H
 
-#define MQ_PORTAL_STATUS "/mq_portal_status"
-#define MQ_PORTAL_TO_SMART "/mq_portal_to_smart"
-#define MQ_SMART_TO_PORTAL "/mq_smart_to_portal"
+#include <signal.h>
+#include <string>
 
+// Shared by the simulation and the ChallanGenerator, StripePayment and
+// UserPortal executables it spawns; nothing here may pull in SFML
+
+// Constants for message queues
+#define MQ_PORTAL_STATUS "/portal_status"
+#define MQ_SMART_TO_CHALLAN "/smart_to_challan" // Shard queues are MQ_SMART_TO_CHALLAN "_<n>";
+                                                // they carry ViolationMsg and settled PaymentMsg
+#define MQ_STRIPE_TO_CHALLAN "/stripe_to_challan"
+#define MQ_CHALLAN_TO_SMART "/challan_to_smart"
+#define MQ_STRIPE_TO_SMART "/stripe_to_smart" // PaymentMsg for each settled payment, for the overlay
+#define MQ_MAX_SIZE 256
+
+// Named semaphores
+#define SEM_LANE "/laneSem"
+#define SEM_ACTIVE_VEHICLES "/activeVehiclesSem"
+
+// Challan worker pool: violations are sharded across workers by plate hash
+#define MAX_CHALLAN_WORKERS 8
+
+// Child executables, looked up next to the simulation's own
+#define CHALLAN_GENERATOR_EXECUTABLE "smarttraffix-challan"
+#define STRIPE_PAYMENT_EXECUTABLE "smarttraffix-stripe"
+#define USER_PORTAL_EXECUTABLE "smarttraffix-portal"
+
+// Structures for messages
 struct PortalStatusMsg {
-    char status[20];
+    char status[16]; // "active" or "inactive"
 };
 
-struct PortalCommandMsg {
-    char command[50];
+// Violation kinds carried by ViolationMsg
+enum ViolationType { SPEEDING, RED_LIGHT, AVERAGE_SPEED, WRONG_LANE };
+
+struct ViolationMsg {
+    char vehicleID[32];
+    int vehicleType; // 1=Light,2=Heavy,3=Emergency
+    int violationType; // ViolationType
+    float speed;
+    double timestamp; // seconds since the epoch when the violation happened
 };
 
-struct ChallanMsg {
-    char vehicleID[20];
+struct PaymentMsg {
+    char vehicleID[32];
     bool paid;
 };
 
-#endif // COMMON_H
+struct ChallanUpdateMsg {
+    char vehicleID[32];
+    bool paid;
+};
+
+// Challan workers tell the two messages on their shard queue apart by size
+static_assert(sizeof(ViolationMsg) != sizeof(PaymentMsg), "shard queue messages must differ in size");
+
+// Name of the violation queue feeding one challan worker
+inline std::string challanShardQueueName(int shard) {
+    return std::string(MQ_SMART_TO_CHALLAN) + "_" + std::to_string(shard);
+}
+
+inline std::string violationTypeName(int violationType) {
+    switch (violationType) {
+        case RED_LIGHT: return "red-light";
+        case AVERAGE_SPEED: return "average-speed";
+        case WRONG_LANE: return "wrong-lane";
+        default: return "speeding";
+    }
+}
 
+// Cleared when the supervisor asks a child to stop
+inline volatile sig_atomic_t childRunning = 1;
+
+// Ctrl+C belongs to the simulation, which stops the children itself with
+// SIGTERM. SIGTERM interrupts a blocking receive so the child can close its queues.
+inline void installChildSignalHandlers() {
+    signal(SIGINT, SIG_IGN);
+    struct sigaction stop = {};
+    stop.sa_handler = [](int) { childRunning = 0; };
+    sigemptyset(&stop.sa_mask);
+    sigaction(SIGTERM, &stop, nullptr);
+}
+
+#endif // COMMON_H
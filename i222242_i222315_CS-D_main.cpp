@@ -1,9 +1,31 @@
 // main.cpp
 
 #include "BankersAlgorithm.h" // Include the Banker's Algorithm header
+#include "BankerShards.h"
+#include "DeadlockBench.h"
+#include "Supervisor.h"
+#include "IncidentDispatch.h"
+#include "LaneGraph.h"
+#include "LaneChange.h"
+#include "ViolationDetection.h"
+#include "SectionControl.h"
+#include "DriverBehavior.h"
+#include "LoopDetector.h"
+#include "SpatBus.h"
+#include "MesoEngine.h"
+#include "EventScheduler.h"
+#include "Collision.h"
+#include "ParallelStep.h"
+#include "Ecs.h"
+#include "StepArena.h"
+#include "common.h"
+#include "AssetLoader.h"
 #include <SFML/Graphics.hpp>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 #include <unistd.h>
 #include <semaphore.h>
 #include <fcntl.h>
@@ -19,11 +41,19 @@
 #include <atomic>
 #include <chrono>
 #include <cstring>
+#include <ctime>
+#include <cstdarg>
+#include <cstdio>
 #include <string>
 #include <thread>
 #include <cerrno>
 #include <cstddef> // For size_t
+#include <cstdint>
 #include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
 
 // Resource types
 enum ResourceType { LANE_SEM, ACTIVE_VEHICLES_SEM, NUM_RESOURCE_TYPES };
@@ -31,34 +61,6 @@ enum ResourceType { LANE_SEM, ACTIVE_VEHICLES_SEM, NUM_RESOURCE_TYPES };
 // Process identifiers
 enum ProcessID { TRAFFIC_LIGHT_CONTROLLER, SPAWN_VEHICLES, SPEED_MANAGER, OUT_OF_ORDER, MOCK_TIME, CHALLAN_GENERATOR, STRIPE_PAYMENT, USER_PORTAL, NUM_PROCESSES };
 
-// Constants for message queues
-#define MQ_PORTAL_STATUS "/portal_status"
-#define MQ_SMART_TO_CHALLAN "/smart_to_challan"
-#define MQ_STRIPE_TO_CHALLAN "/stripe_to_challan"
-#define MQ_CHALLAN_TO_SMART "/challan_to_smart"
-#define MQ_MAX_SIZE 256
-
-// Structures for messages
-struct PortalStatusMsg {
-    char status[16]; // "active" or "inactive"
-};
-
-struct SpeedViolationMsg {
-    char vehicleID[32];
-    int vehicleType; // 1=Light,2=Heavy,3=Emergency
-    float speed;
-};
-
-struct PaymentMsg {
-    char vehicleID[32];
-    bool paid;
-};
-
-struct ChallanUpdateMsg {
-    char vehicleID[32];
-    bool paid;
-};
-
 // Enum for vehicle types
 enum VehicleType { LIGHT, HEAVY, EMERGENCY };
 
@@ -73,17 +75,35 @@ struct Vehicle {
     sf::Vector2f speedVector;
     float currentSpeed;
     std::string numberPlate;
-    bool challanActive = false;
-    bool outOfOrder = false;
-    bool isTowed = false;
     std::string laneName; // Added lane information
+    DriverProfile profile = NORMAL; // drives currentSpeed around a profile-specific desired speed
+    double spawnedAt = 0.0;      // seconds since the epoch when the trip started
+    int mesoTrip = -1;           // hybrid mode: the meso trip this vehicle continues
+    int mesoLink = -1;           // hybrid mode: the handoff link it arrived on
+};
+
+// Components of the entities on the road. A vehicle waits in its lane queue as a plain
+// Vehicle and becomes an entity with Vehicle and Driving components when it is discharged.
+
+// State of a vehicle driving under its own power; a breakdown swaps it for Breakdown
+struct Driving {
+    float realizedSpeed = 0.f;   // speed actually achieved last frame behind the vehicle ahead
+    bool committed = false;      // was moving in the dilemma zone at amber and will not stop
+    bool speeding = false;       // flagged for speeding and not yet slowed well below maxSpeed
+    float laneChangeCooldown = 0.f; // seconds before the vehicle may change lanes again
+    sf::Vector2f stepFrom;       // position at the start of the last step, for swept collision tests
+    float fromProgress = 0.f;    // distance along the lane at the start of the last step
+    float step = 0.f;            // distance moved along the lane in the last step
+    bool changedLaneByChoice = false; // the last step was a discretionary lane change
 };
 
-// Traffic Light structure
-struct TrafficLight {
-    std::string direction; // e.g., North, South, East, West
-    TrafficLightState state;
-    sf::CircleShape lightShape;
+// Broken down and blocking its lane until a tow truck clears it
+struct Breakdown {};
+
+// A traffic light for one approach; its colour comes from the SPaT bus
+struct SignalHead {
+    std::string approach; // e.g., North, South, East, West
+    sf::CircleShape shape;
 };
 
 // LaneQueue structure
@@ -124,16 +144,163 @@ void safePrint(Args... args) {
     }
 }
 
+// printf-style safePrint for the simulation step: formats into a stack buffer, so
+// logging there makes no heap allocations. Longer lines are truncated.
+void safePrintf(const char *format, ...) {
+    if (portalActive.load()) return;
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    safePrint(line);
+}
+
 // Global texture variables
 sf::Texture roadTexture, carTexture1, carTexture2, towTruckTexture;
 
+// Entry positions, directions, and rotations of lanes
+static std::map<std::string, sf::Vector2f> lanePositions = {
+    {"North1", {380, 0}}, {"North2", {400, 0}}, {"South1", {410, 600}}, {"South2", {430, 600}},
+    {"East1", {800, 250}}, {"East2", {800, 290}}, {"West1", {0, 310}}, {"West2", {0, 350}}};
+
+static std::map<std::string, sf::Vector2f> laneDirections = {
+    {"North1", {0, 1}}, {"North2", {0, 1}}, {"South1", {0, -1}}, {"South2", {0, -1}},
+    {"East1", {-1, 0}}, {"East2", {-1, 0}}, {"West1", {1, 0}}, {"West2", {1, 0}}};
+
+static std::map<std::string, float> laneRotations = {
+    {"North1", 180.0f}, {"North2", 180.0f}, {"South1", 0.0f}, {"South2", 0.0f},
+    {"East1", -90.0f}, {"East2", -90.0f}, {"West1", 90.0f}, {"West2", 90.0f}};
+
 // Other global variables (queues, semaphores)
-static std::vector<Vehicle> activeVehicles;
+static Registry world; // vehicles on the road and signal heads
+static SystemTimer systems;
+
+// Transient data of one simulation step: lane orders, lane-change slots, loop
+// detector fronts and collision scratch. Reset at the start of every step.
+// The densest run measured (--spawn-interval 0.2) peaked at 81 vehicles on the
+// road and 9 KB of arena; the step's reused buffers and the arena are sized
+// with room to spare so no step has to grow them.
+static const size_t STEP_RESERVED_VEHICLES = 256;
+static const size_t STEP_ARENA_BYTES = 64 * 1024;
+
+// A reused step buffer with room for `n` items from the start
+template <typename T>
+T reservedBuffer(size_t n = STEP_RESERVED_VEHICLES) {
+    T buffer;
+    buffer.reserve(n);
+    return buffer;
+}
+static StepArena stepArena(STEP_ARENA_BYTES);
 static std::map<std::string, LaneQueue> laneQueues;
-static std::map<std::string, bool> activeChallans; // vehicleID -> challanActive
+static std::map<std::string, float> laneTailProgress; // lane -> progress of its rear-most moving vehicle, max if none
+
+// Car-following and lane capacity, in pixels along the lane
+static const float MIN_GAP = 30.f;          // bumper gap kept behind the vehicle ahead
+static const float VEHICLE_SPACING = 35.f;  // lane length one queued vehicle occupies
+static const float MERGE_LOOKAHEAD = 60.f;  // distance to a blockage at which vehicles try to merge
+static const int LANE_SEGMENT_CAPACITY = 12;
+static const float LANE_CHANGE_COOLDOWN_SECONDS = 1.f;
+static const float DILEMMA_ZONE = 40.f;     // too close to the stop line to stop for amber
+
+// Stop lines, as a distance from each lane's entry
+static std::map<std::string, float> laneStopDistances = {
+    {"North1", 230.f}, {"North2", 230.f}, {"South1", 230.f}, {"South2", 230.f},
+    {"East1", 320.f}, {"East2", 320.f}, {"West1", 320.f}, {"West2", 320.f}};
+static std::map<std::string, StopLine> laneStopLines;
+
+// Violations detected in the movement pass, sent to the challan workers by the next flush event
+static std::vector<ViolationMsg> pendingViolations;
+static int totalSpeedingViolations = 0;
+static int totalRedLightViolations = 0;
+static int totalAverageSpeedViolations = 0;
+static int totalWrongLaneViolations = 0;
+
+// Heavy vehicles must keep to lane 1 of each pair except to merge around a breakdown
+static const char HEAVY_RESTRICTED_LANE = '2';
+
+// A vehicle covers currentSpeed * SPEED_TO_PIXELS_PER_SEC px per simulated second. Frames are
+// FRAME_SECONDS apart by default; --dt sets a longer step, which the swept collision test covers.
+static const unsigned int FRAME_RATE = 60;
+static const double FRAME_SECONDS = 1.0 / FRAME_RATE;
+static const double MAX_STEP_SECONDS = 1.0;
+static const float SPEED_TO_PIXELS_PER_SEC = 0.01f * FRAME_RATE;
+static double stepSeconds = FRAME_SECONDS; // simulated seconds per frame
+// The analytics overlay is rebuilt at most this often (wall clock), not every frame
+static const double OVERLAY_REFRESH_SECONDS = 0.25;
+
+// A vehicle flagged for speeding is flagged again only after slowing below this
+// share of its limit, so noise around the limit does not raise a stream of challans
+static const float SPEEDING_REARM_RATIO = 0.9f;
+
+// Section control cameras, as a distance from each lane's entry. A section covers
+// both lanes of an approach so lane changes inside it do not lose the plate.
+static const float SECTION_ENTRY_CAMERA = 20.f;
+static std::map<std::string, float> sectionExitCameras = {
+    {"North", 580.f}, {"South", 580.f}, {"East", 780.f}, {"West", 780.f}};
+static const double SECTION_WINDOW_SECONDS = 120.0; // entry reads older than this are dropped
+
+// Loop detectors: an advance loop near each lane entry and a stop-bar loop just before the stop line
+static const float VEHICLE_LENGTH = 20.f;
+static const float DETECTOR_LENGTH = 15.f;
+static const float ADVANCE_DETECTOR_DISTANCE = 100.f;
+static const float STOP_BAR_DETECTOR_SETBACK = 20.f;
+static const double DETECTOR_SAMPLE_SECONDS = 1.0;
+static const size_t DETECTOR_RING_CAPACITY = 256;
+
+// Actuated signal timing: green runs at least MIN_GREEN_SECONDS, then ends once the
+// green approaches' loops see no arrival for GAP_OUT_SECONDS, or at MAX_GREEN_SECONDS
+static const double MIN_GREEN_SECONDS = 5.0;
+static const double MAX_GREEN_SECONDS = 20.0;
+static const double GAP_OUT_SECONDS = 2.0;
+static const double YELLOW_SECONDS = 3.0;
+
+// Discrete-event simulation. Everything that changes the intersection is a timestamped
+// event; frames are only scheduled while something is on the road, so an idle
+// intersection costs a window poll and the occasional signal change.
+enum SimEventType {
+    SIM_SPAWN, SIM_SIGNAL, SIM_DISCHARGE, SIM_FRAME, SIM_BREAKDOWN,
+    SIM_CLOCK_TICK, SIM_VIOLATION_FLUSH, SIM_MESO_ADVANCE, SIM_WINDOW_POLL
+};
+static const double SPAWN_INTERVAL_SECONDS = 1.0;
+static const double BREAKDOWN_CHECK_SECONDS = 30.0;
+static const double MOCK_MINUTE_SECONDS = 60.0;    // simulated seconds per mock-time minute
+static const double WINDOW_POLL_SECONDS = 0.1;     // window events while no frames are running
+static const double HANDOFF_RETRY_SECONDS = 0.1;   // hybrid: retry trips waiting for a full lane queue
+static const double FLUSH_RETRY_SECONDS = 0.5;     // retry violations a full challan queue turned away
+static const size_t MAX_PENDING_VIOLATIONS = 1024; // beyond this the oldest unsent violations are dropped
+
+// SPaT messages are also sent to this local UDP port, standing in for a roadside broadcaster
+#define SPAT_UDP_PORT 47047
+
+// Lane-change model between paired lanes
+static IdmParams idmParams;
+static MobilParams mobilParams;
+static bool laneChangesEnabled = true; // toggled with 'L' to compare approach throughput
+
+// Approach throughput: vehicles released from the lane queues since the counter was reset
+static int vehiclesDischarged = 0;
+static double throughputSince = 0.0; // simulation clock when the counter was reset
+
+// Trip KPIs over the same period, matching the ones the mesoscopic engine reports
+static int tripsCompleted = 0;
+static double totalTravelTime = 0.0;
+
+// Mesoscopic mode: fixed-time signals, since meso links have no loop detectors
+static const double MESO_GREEN_SECONDS = 10.0;
+static const float MESO_LINK_LENGTH = 600.f;
+
+// Hybrid mode: the micro intersection replaces one cell of a meso grid. Trips reaching
+// its approaches are handed to the lane queues, and return to the grid when they leave.
+static bool hybridMode = false;
+static int hybridRow = 0, hybridCol = 0;
+static std::vector<MesoHandoff> pendingHandoffs; // handed over, waiting for room in a lane queue
+static std::map<int, std::string> handoffApproach; // handoff link -> micro approach
+static std::map<std::string, int> approachDirection = {
+    {"North", MESO_SOUTHBOUND}, {"South", MESO_NORTHBOUND}, {"East", MESO_WESTBOUND}, {"West", MESO_EASTBOUND}};
 
 sem_t *laneSem = SEM_FAILED;            // Protects laneQueues
-sem_t *activeVehiclesSem = SEM_FAILED;  // Protects activeVehicles
+sem_t *activeVehiclesSem = SEM_FAILED;  // Protects the vehicles in `world`
 
 // Analytics Counters
 static int totalChallansIssued = 0;
@@ -141,39 +308,132 @@ static int totalChallansPaid = 0;
 static int totalVehiclesOutOfOrder = 0;
 
 // Message Queue Handles
-mqd_t mqSmartToChallan = (mqd_t)-1;
+mqd_t mqSmartToChallanShards[MAX_CHALLAN_WORKERS];
 mqd_t mqStripeToChallan = (mqd_t)-1;
 mqd_t mqChallanToSmart = (mqd_t)-1;
+mqd_t mqStripeToSmart = (mqd_t)-1;
 mqd_t mqPortalStatusHandle = (mqd_t)-1;
 
 // Mock Time
 MockTime mockTime;
 
-// Traffic Lights
-std::map<std::string, TrafficLight> trafficLights;
-
-// Initialize Banker's Algorithm
-BankersAlgorithm banker(NUM_RESOURCE_TYPES, NUM_PROCESSES);
+// Signal phase and timing from the controller to the renderer, queue admission,
+// vehicles and the UDP broadcaster
+SpatBus spatBus;
+
+// Banker's Algorithm, one shard per intersection. This process simulates a
+// single intersection in detail, so it has one shard.
+BankerShards bankers(1, NUM_RESOURCE_TYPES, NUM_PROCESSES);
+BankersAlgorithm &banker = bankers.shard(0);
+
+// Supervises the ChallanGenerator, StripePayment and UserPortal processes
+Supervisor supervisor;
+
+// Breakdown tracking and tow truck dispatch (100px index cells, 3s hook-up)
+IncidentDispatcher dispatcher(100.f, 3.0);
+
+// Lane capacity graph: each lane's queue feeds its road segment
+LaneGraph laneGraph;
+
+// Average-speed enforcement between the entry and exit cameras of each approach
+SectionControl sectionControl(SECTION_WINDOW_SECONDS);
+
+// Loop detectors, sampled every frame; the signal controller and the
+// analytics overlay each drain their own ring
+LoopDetectorBank loopDetectors(DETECTOR_SAMPLE_SECONDS, VEHICLE_LENGTH);
+DetectorRing *controllerDetectorFeed = nullptr;
+DetectorRing *analyticsDetectorFeed = nullptr;
+
+// Mesoscopic network around the micro intersection in hybrid mode
+MesoEngine mesoEngine(std::random_device{}());
+
+// Start of main(), for the time-to-first-frame report
+static std::chrono::steady_clock::time_point startupBegin;
+static bool firstFrameShown = false;
+static double assetDecodeMs = 0.0, assetSerialDecodeMs = 0.0, assetUploadMs = 0.0;
+
+// Event list and clock of the simulation; every handler runs on the main thread
+EventScheduler scheduler;
+static double simEpoch = 0.0;   // wall clock when the simulation started
+static bool fastMode = false;   // --fast: run ahead of real time, skipping idle stretches
+// --parallel: std::execution::par for integration and compaction. Off by default until
+// a multi-core run shows it paying for itself; on one core it measured 0.86-0.94x.
+static bool parallelStep = false;
+static double spawnInterval = SPAWN_INTERVAL_SECONDS;
+static std::mt19937 simGen(std::random_device{}());
+
+// Follow-up events already on the list, so each is only scheduled once
+static bool framePending = false;
+static double lastFrameAt = -1.0;
+static bool dischargePending = false;
+static bool flushPending = false;
+static int mesoAdvanceGeneration = 0; // only the latest SIM_MESO_ADVANCE is acted on
+static double mesoAdvanceAt = std::numeric_limits<double>::infinity();
+
+// Actuated controller state between SIM_SIGNAL events
+static int signalPhase = 0;         // 0 serves North-South, 1 East-West
+static bool signalAmber = false;
+static double greenStartedAt = 0.0;
+static std::map<std::string, double> lastArrival; // latest sample with a vehicle on an approach's loops
+
+// Number of ChallanGenerator workers, one per core up to MAX_CHALLAN_WORKERS
+int numChallanWorkers = 1;
 
 // Function Declarations
-void handleCollisionsAndCleanup();
-void performCleanup(pid_t pid1, pid_t pid2, pid_t pid3, pid_t pid4);
-void cleanupAndExit(int signum);
-void trafficLightControllerThread();
-void spawnVehiclesThread(sf::Texture *carTexture1, sf::Texture *carTexture2, sf::Texture *towTruckTexture);
-void speedManagerThread();
-void outOfOrderThread();
-void mockTimeThread();
-void challanGeneratorProcess();
-void stripePaymentProcess();
-void userPortalProcess();
-void processQueues();
-void runDeadlockPrevention();
-void visualizeTraffic(sf::RenderWindow &window, sf::Sprite &roadSprite, sf::Font &font, sf::Text &analyticsText);
+void performCleanup();
+void requestShutdown(int signum);
+void signalControllerEvent();
+void publishSpat(int phase, TrafficLightState servedState, double minEndTime, double maxEndTime);
+void spatBroadcasterThread();
+void spawnVehicleEvent();
+void flushViolations();
+void breakdownEvent();
+void mockTimeEvent();
+void requestFrame();
+void requestDischarge();
+void dischargeEvent();
+bool roadBusy();
+void frameEvent(sf::RenderWindow &window, sf::Sprite &roadSprite, sf::Text &analyticsText);
+void drainPaymentReports();
+void pollWindowEvents(sf::RenderWindow &window);
+void runSimulation(sf::RenderWindow &window, sf::Sprite &roadSprite, sf::Text &analyticsText);
+int challanShardFor(const std::string &plate);
+std::string siblingExecutable(const char *name);
+bool processQueues();
+void balanceLaneQueues();
+void visualizeTraffic(sf::RenderWindow &window, sf::Sprite &roadSprite, sf::Text &analyticsText);
+int runMesoscopic(int rows, int cols, long long trips);
+int runStepBenchmark(size_t vehicleCount, int steps);
+int runBankerBenchmark(long long iterations);
+void integrateVehicles(Registry &registry, bool parallel);
+size_t movementSystem(const SpatMessage &spat, float dt, LaneFronts &laneFronts);
+size_t violationSystem(const SpatMessage &spat, double stepStartWall, double stepWall);
+size_t exitSystem(double stepWall);
+size_t collisionSystem();
+size_t renderSystem(sf::RenderWindow &window, const SpatMessage &spat);
+Entity putOnRoad(const Vehicle &vehicle);
+bool outsideWindow(const sf::Vector2f &position);
+MesoGridParams mesoGridParams();
+double hybridSeconds();
+bool admitMesoHandoffs(std::vector<MesoHandoff> &pending, sf::Texture *carTexture1, sf::Texture *carTexture2,
+                       sf::Texture *towTruckTexture, std::mt19937 &gen);
+void scheduleMesoAdvance();
+void mesoAdvanceEvent(int generation);
+Vehicle createVehicle(int vehicleTypeChoice, const std::string &lane, sf::Texture *carTexture1,
+                      sf::Texture *carTexture2, sf::Texture *towTruckTexture, std::mt19937 &gen);
+void enqueueVehicle(const Vehicle &vehicle);
+void removeVehicle(Entity e);
 bool acquireResource(int process, ResourceType res);
 void releaseResource(int process, ResourceType res);
 void initializeBankers();
 void initializeTrafficLights();
+float laneProgress(const Vehicle &v);
+std::string adjacentLane(const std::string &lane);
+std::string laneQueueNode(const std::string &lane);
+std::string laneApproach(const std::string &lane);
+double simClockSeconds();
+ViolationMsg makeViolation(const Vehicle &v, int violationType, float speed, double timestamp);
+bool sendViolation(const ViolationMsg &violationMsg);
 
 // Function Definitions
 
@@ -193,8 +453,7 @@ void initializeBankers() {
 
 // Acquire resource using Banker's Algorithm
 bool acquireResource(int process, ResourceType res) {
-    std::vector<int> request(NUM_RESOURCE_TYPES, 0);
-    request[res] = 1; // Requesting 1 unit of the semaphore
+    ResourceVector request = singleUnit(res); // Requesting 1 unit of the semaphore
 
     if (banker.requestResources(process, request)) {
         // If allocation is safe, proceed to acquire the semaphore
@@ -222,8 +481,7 @@ bool acquireResource(int process, ResourceType res) {
 
 // Release resource using Banker's Algorithm
 void releaseResource(int process, ResourceType res) {
-    std::vector<int> release(NUM_RESOURCE_TYPES, 0);
-    release[res] = 1; // Releasing 1 unit of the semaphore
+    ResourceVector release = singleUnit(res); // Releasing 1 unit of the semaphore
 
     // Release the semaphore
     if (res == LANE_SEM) {
@@ -241,6 +499,61 @@ void releaseResource(int process, ResourceType res) {
     banker.releaseResources(process, release);
 }
 
+// Distance a vehicle has travelled along its lane from the lane entry
+float laneProgress(const Vehicle &v) {
+    sf::Vector2f offset = v.sprite.getPosition() - lanePositions[v.laneName];
+    const sf::Vector2f &dir = laneDirections[v.laneName];
+    return offset.x * dir.x + offset.y * dir.y;
+}
+
+// The other lane of a pair, e.g. North1 <-> North2
+std::string adjacentLane(const std::string &lane) {
+    std::string other = lane;
+    other.back() = (lane.back() == '1') ? '2' : '1';
+    return other;
+}
+
+// Lane graph node for the queue waiting to enter a lane
+std::string laneQueueNode(const std::string &lane) {
+    return lane + "/queue";
+}
+
+// Traffic light direction controlling a lane, e.g. North2 -> North
+std::string laneApproach(const std::string &lane) {
+    return lane.substr(0, lane.size() - 1);
+}
+
+// Simulation time as seconds since the epoch, used to timestamp violations: the wall clock
+// at the start of the run plus the scheduler's clock, so it also holds when running --fast
+double simClockSeconds() {
+    return simEpoch + scheduler.now();
+}
+
+ViolationMsg makeViolation(const Vehicle &v, int violationType, float speed, double timestamp) {
+    ViolationMsg violationMsg;
+    std::strncpy(violationMsg.vehicleID, v.numberPlate.c_str(), sizeof(violationMsg.vehicleID) - 1);
+    violationMsg.vehicleID[sizeof(violationMsg.vehicleID) - 1] = '\0';
+    violationMsg.vehicleType = v.type;
+    violationMsg.violationType = violationType;
+    violationMsg.speed = speed;
+    violationMsg.timestamp = timestamp;
+    return violationMsg;
+}
+
+// Route a violation to the challan worker owning the vehicle's plate.
+// The queues are non-blocking, so a full shard returns false with errno EAGAIN.
+bool sendViolation(const ViolationMsg &violationMsg) {
+    mqd_t shardQueue = mqSmartToChallanShards[challanShardFor(violationMsg.vehicleID)];
+    if (mq_send(shardQueue, reinterpret_cast<const char*>(&violationMsg), sizeof(violationMsg), 0) == -1) {
+        if (errno != EAGAIN) {
+            std::cerr << "[SpeedManager] Failed to send violation message: " << strerror(errno) << std::endl;
+        }
+        return false;
+    }
+    totalChallansIssued++;
+    return true;
+}
+
 // Initialize Traffic Lights
 void initializeTrafficLights() {
     // Define directions
@@ -248,605 +561,531 @@ void initializeTrafficLights() {
 
     // Initialize traffic lights with initial states
     for (const auto &dir : directions) {
-        TrafficLight tl;
-        tl.direction = dir;
-        tl.state = RED;
+        SignalHead tl;
+        tl.approach = dir;
 
         // Initialize SFML CircleShape for visualization
-        tl.lightShape = sf::CircleShape(10.f);
+        tl.shape = sf::CircleShape(10.f);
         if (dir == "North") {
-            tl.lightShape.setPosition(380.f, 50.f);
+            tl.shape.setPosition(380.f, 50.f);
         }
         else if (dir == "South") {
-            tl.lightShape.setPosition(410.f, 500.f);
+            tl.shape.setPosition(410.f, 500.f);
         }
         else if (dir == "East") {
-            tl.lightShape.setPosition(700.f, 250.f);
+            tl.shape.setPosition(700.f, 250.f);
         }
         else if (dir == "West") {
-            tl.lightShape.setPosition(100.f, 310.f);
+            tl.shape.setPosition(100.f, 310.f);
         }
 
-        tl.lightShape.setFillColor(sf::Color::Red);
-        trafficLights[dir] = tl;
+        tl.shape.setFillColor(sf::Color::Red);
+        world.add<SignalHead>(world.create(), tl);
     }
 
-    // Set initial green light for North-South
-    trafficLights["North"].state = GREEN;
-    trafficLights["South"].state = GREEN;
-    trafficLights["North"].lightShape.setFillColor(sf::Color::Green);
-    trafficLights["South"].lightShape.setFillColor(sf::Color::Green);
+    // Start with North-South green, so every subscriber has a message from the outset
+    double now = simClockSeconds();
+    signalPhase = 0;
+    signalAmber = false;
+    greenStartedAt = scheduler.now();
+    publishSpat(0, GREEN, now + MIN_GREEN_SECONDS, now + MAX_GREEN_SECONDS);
 }
 
-// Traffic Light Controller Thread
-void trafficLightControllerThread() {
-    std::vector<std::string> directions = {"North", "South", "East", "West"};
-    size_t currentGreenIndex = 0; // Start with North-South
+// Publish a phase change: the phase's two approaches get `servedState`, all others are red.
+// Phase 0 serves North-South, phase 1 East-West.
+void publishSpat(int phase, TrafficLightState servedState, double minEndTime, double maxEndTime) {
+    SpatMessage msg;
+    msg.publishedAt = simClockSeconds();
+    msg.phase = phase;
+    for (int a = 0; a < NUM_SPAT_APPROACHES; ++a) {
+        msg.state[a] = RED;
+    }
+    msg.state[phase == 0 ? SPAT_NORTH : SPAT_EAST] = servedState;
+    msg.state[phase == 0 ? SPAT_SOUTH : SPAT_WEST] = servedState;
+    msg.minEndTime = minEndTime;
+    msg.maxEndTime = maxEndTime;
+    spatBus.publish(msg);
+}
 
-    while (running) {
-        // Green phase
-        std::this_thread::sleep_for(std::chrono::seconds(10)); // Green lasts 10 seconds
+// Traffic Light Controller
+// Runs at the end of amber and whenever the green might end: at minimum green, then
+// when the served approaches' last arrival is GAP_OUT_SECONDS old, or at maximum green.
+void signalControllerEvent() {
+    static const std::string directions[] = {"North", "South", "East", "West"};
+    const std::string &greenA = directions[signalPhase * 2];
+    const std::string &greenB = directions[signalPhase * 2 + 1];
+    double now = simClockSeconds();
+
+    if (signalAmber) {
+        // Served approaches turn red as the other axis turns green
+        signalPhase = 1 - signalPhase;
+        signalAmber = false;
+        greenStartedAt = scheduler.now();
+        publishSpat(signalPhase, GREEN, now + MIN_GREEN_SECONDS, now + MAX_GREEN_SECONDS);
+        safePrint("[TrafficLightController] " + greenA + "/" + greenB + " traffic lights turned RED, " +
+                  directions[signalPhase * 2] + "/" + directions[signalPhase * 2 + 1] + " turned GREEN.");
+        scheduler.scheduleAfter(MIN_GREEN_SECONDS, SIM_SIGNAL);
+        requestDischarge();
+        requestFrame();
+        return;
+    }
 
-        // Transition to Yellow
-        {
-            std::lock_guard<std::mutex> lock(printMutex);
-            trafficLights[directions[currentGreenIndex]].state = YELLOW;
-            trafficLights[directions[currentGreenIndex]].lightShape.setFillColor(sf::Color::Yellow);
-            trafficLights[directions[currentGreenIndex] + (currentGreenIndex == 0 ? "" : "")].state = YELLOW;
-            trafficLights[directions[currentGreenIndex] + (currentGreenIndex == 0 ? "" : "")].lightShape.setFillColor(sf::Color::Yellow);
-            safePrint("[TrafficLightController] " + directions[currentGreenIndex] + " traffic lights turned YELLOW.");
+    // Green phase, actuated by the loop detectors of the two approaches being served
+    DetectorSample sample;
+    while (controllerDetectorFeed->pop(sample)) {
+        if (sample.count > 0 || sample.occupancy > 0.f) {
+            lastArrival[laneApproach(loopDetectors.getLane(sample.detector))] = sample.time;
         }
+    }
 
-        std::this_thread::sleep_for(std::chrono::seconds(3)); // Yellow lasts 3 seconds
+    double elapsed = scheduler.now() - greenStartedAt;
+    double gapOutAt = -std::numeric_limits<double>::infinity(); // simulation clock
+    if (lastArrival.count(greenA)) gapOutAt = std::max(gapOutAt, lastArrival[greenA] + GAP_OUT_SECONDS);
+    if (lastArrival.count(greenB)) gapOutAt = std::max(gapOutAt, lastArrival[greenB] + GAP_OUT_SECONDS);
 
-        // Transition to Red
-        {
-            std::lock_guard<std::mutex> lock(printMutex);
-            trafficLights[directions[currentGreenIndex]].state = RED;
-            trafficLights[directions[currentGreenIndex]].lightShape.setFillColor(sf::Color::Red);
-            trafficLights[directions[currentGreenIndex] + (currentGreenIndex == 0 ? "" : "")].state = RED;
-            trafficLights[directions[currentGreenIndex] + (currentGreenIndex == 0 ? "" : "")].lightShape.setFillColor(sf::Color::Red);
-            safePrint("[TrafficLightController] " + directions[currentGreenIndex] + " traffic lights turned RED.");
-        }
+    if (elapsed < MIN_GREEN_SECONDS) {
+        scheduler.schedule(greenStartedAt + MIN_GREEN_SECONDS, SIM_SIGNAL);
+        return;
+    }
+    if (elapsed < MAX_GREEN_SECONDS && now < gapOutAt) {
+        // Extended: look again when the gap would run out, new arrivals permitting
+        scheduler.schedule(std::min(greenStartedAt + MAX_GREEN_SECONDS, scheduler.now() + (gapOutAt - now)), SIM_SIGNAL);
+        return;
+    }
 
-        // Move to next direction
-        currentGreenIndex = (currentGreenIndex + 2) % directions.size(); // Toggle between NS and EW
+    // Transition to Yellow
+    signalAmber = true;
+    publishSpat(signalPhase, YELLOW, now + YELLOW_SECONDS, now + YELLOW_SECONDS);
+    safePrint("[TrafficLightController] " + greenA + "/" + greenB + " traffic lights turned YELLOW.");
+    scheduler.scheduleAfter(YELLOW_SECONDS, SIM_SIGNAL);
+    requestFrame();
+}
+
+// SPaT broadcaster stand-in: every published message goes out as one UDP datagram to a
+// local port, sent straight from the bus's shared buffer
+void spatBroadcasterThread() {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == -1) {
+        perror("socket spat broadcaster");
+        return;
+    }
 
-        // Set next direction to Green
-        {
-            std::lock_guard<std::mutex> lock(printMutex);
-            trafficLights[directions[currentGreenIndex]].state = GREEN;
-            trafficLights[directions[currentGreenIndex]].lightShape.setFillColor(sf::Color::Green);
-            trafficLights[directions[currentGreenIndex] + (currentGreenIndex == 0 ? "" : "")].state = GREEN;
-            trafficLights[directions[currentGreenIndex] + (currentGreenIndex == 0 ? "" : "")].lightShape.setFillColor(sf::Color::Green);
-            safePrint("[TrafficLightController] " + directions[currentGreenIndex] + " traffic lights turned GREEN.");
+    sockaddr_in dest;
+    std::memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(SPAT_UDP_PORT);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    unsigned long seen = 0;
+    while (running) {
+        std::shared_ptr<const SpatMessage> msg = spatBus.waitNewer(seen, 500);
+        if (!msg) continue;
+        seen = msg->sequence;
+        if (sendto(sock, msg.get(), sizeof(SpatMessage), 0, reinterpret_cast<const sockaddr*>(&dest), sizeof(dest)) == -1) {
+            std::cerr << "[SpatBroadcaster] Failed to send SPaT message: " << strerror(errno) << std::endl;
         }
     }
+    close(sock);
 }
 
-// Spawn Vehicles Thread
-void spawnVehiclesThread(sf::Texture *carTexture1, sf::Texture *carTexture2, sf::Texture *towTruckTexture) {
-    std::vector<std::string> lanes = {"North1", "North2", "South1", "South2", "East1", "East2", "West1", "West2"};
-    std::random_device rd;
-    std::mt19937 gen(rd());
+// Spawn Vehicles
+// One spawn attempt every spawnInterval seconds; the new vehicle waits in its lane queue
+void spawnVehicleEvent() {
+    static const std::vector<std::string> lanes = {"North1", "North2", "South1", "South2", "East1", "East2", "West1", "West2"};
     std::uniform_int_distribution<> laneDist(0, static_cast<int>(lanes.size()) - 1);
     std::uniform_int_distribution<> typeDist(1, 3); // 1=Light,2=Heavy,3=Emergency
 
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        std::string selectedLane = lanes[laneDist(gen)];
+    scheduler.scheduleAfter(spawnInterval, SIM_SPAWN);
+    std::string selectedLane = lanes[laneDist(simGen)];
+
+    // Acquire LANE_SEM using Banker's Algorithm
+    if (!acquireResource(SPAWN_VEHICLES, LANE_SEM)) {
+        safePrint("[Banker] SpawnVehicles: Waiting for LANE_SEM resource.");
+        return; // Retry at the next spawn
+    }
 
-        // Acquire LANE_SEM using Banker's Algorithm
-        if (!acquireResource(SPAWN_VEHICLES, LANE_SEM)) {
-            safePrint("[Banker] SpawnVehicles: Waiting for LANE_SEM resource.");
-            continue; // Retry in the next iteration
+    if (static_cast<int>(laneQueues[selectedLane].vehicles.size()) < laneQueues[selectedLane].maxCapacity) {
+        int vehicleTypeChoice = typeDist(simGen);
+        // Check peak hours restriction for heavy
+        if (vehicleTypeChoice == 2 && mockTime.isPeakHours()) {
+            safePrint("[SpawnVehicles] Heavy vehicle attempted to spawn during peak hours. Skipping.");
+            releaseResource(SPAWN_VEHICLES, LANE_SEM);
+            return;
         }
 
-        if (static_cast<int>(laneQueues[selectedLane].vehicles.size()) < laneQueues[selectedLane].maxCapacity) {
-            int vehicleTypeChoice = typeDist(gen);
-            // Check peak hours restriction for heavy
-            if (vehicleTypeChoice == 2 && mockTime.isPeakHours()) {
-                safePrint("[SpawnVehicles] Heavy vehicle attempted to spawn during peak hours. Skipping.");
+        // Heavy vehicles enter in lane 1, where they are allowed
+        if (vehicleTypeChoice == 2 && selectedLane.back() == HEAVY_RESTRICTED_LANE) {
+            selectedLane = adjacentLane(selectedLane);
+            if (static_cast<int>(laneQueues[selectedLane].vehicles.size()) >= laneQueues[selectedLane].maxCapacity) {
                 releaseResource(SPAWN_VEHICLES, LANE_SEM);
-                continue;
+                return;
             }
-
-            Vehicle newVehicle;
-            if (vehicleTypeChoice == 1) {
-                newVehicle.type = LIGHT;
-                newVehicle.maxSpeed = 60.0f;
-                newVehicle.sprite.setTexture(*carTexture1);
-            } else if (vehicleTypeChoice == 2) {
-                newVehicle.type = HEAVY;
-                newVehicle.maxSpeed = 40.0f;
-                newVehicle.sprite.setTexture(*carTexture2);
-            } else {
-                newVehicle.type = EMERGENCY;
-                newVehicle.maxSpeed = 90.0f; // Faster for emergency
-                newVehicle.sprite.setTexture(*towTruckTexture); // Use tow truck texture for emergency
-            }
-
-            newVehicle.sprite.setScale(0.05f, 0.05f); // Reduced scale for better alignment
-            newVehicle.speedVector = sf::Vector2f(0.f, 0.f); // Will be set based on lane
-            newVehicle.currentSpeed = newVehicle.maxSpeed;
-            newVehicle.numberPlate = "ABC-" + std::to_string(rand() % 9999);
-            newVehicle.laneName = selectedLane;
-
-            // Set initial position based on lane
-            if (selectedLane.find("North") != std::string::npos) {
-                newVehicle.sprite.setPosition(400.f, 0.f);
-                newVehicle.speedVector = sf::Vector2f(0.f, 1.f);
-            }
-            else if (selectedLane.find("South") != std::string::npos) {
-                newVehicle.sprite.setPosition(400.f, 600.f);
-                newVehicle.speedVector = sf::Vector2f(0.f, -1.f);
-            }
-            else if (selectedLane.find("East") != std::string::npos) {
-                newVehicle.sprite.setPosition(800.f, 300.f);
-                newVehicle.speedVector = sf::Vector2f(-1.f, 0.f);
-            }
-            else if (selectedLane.find("West") != std::string::npos) {
-                newVehicle.sprite.setPosition(0.f, 300.f);
-                newVehicle.speedVector = sf::Vector2f(1.f, 0.f);
-            }
-
-            // Priority Handling: emergency front, else back
-            if (newVehicle.type == EMERGENCY) {
-                laneQueues[selectedLane].vehicles.push_front(newVehicle);
-            } else {
-                laneQueues[selectedLane].vehicles.push_back(newVehicle);
-            }
-
-            safePrint("[SpawnVehicles] Spawned vehicle: " + newVehicle.numberPlate +
-                      " Type: " + (newVehicle.type == LIGHT ? "Light" :
-                                   newVehicle.type == HEAVY ? "Heavy" : "Emergency") +
-                      " Speed:" + std::to_string(newVehicle.currentSpeed) +
-                      " Lane:" + newVehicle.laneName);
         }
 
-        // Release LANE_SEM after processing
-        releaseResource(SPAWN_VEHICLES, LANE_SEM);
+        enqueueVehicle(createVehicle(vehicleTypeChoice, selectedLane, &carTexture1, &carTexture2, &towTruckTexture, simGen));
+        requestDischarge();
     }
+
+    // Release LANE_SEM after processing
+    releaseResource(SPAWN_VEHICLES, LANE_SEM);
 }
 
-// Speed Manager Thread
-void speedManagerThread() {
-    // Implement speed management by monitoring vehicle speeds
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Adjust frequency as needed
+// Builds a vehicle of the given type (1=Light,2=Heavy,3=Emergency) at the entry of `lane`
+Vehicle createVehicle(int vehicleTypeChoice, const std::string &lane, sf::Texture *carTexture1,
+                      sf::Texture *carTexture2, sf::Texture *towTruckTexture, std::mt19937 &gen) {
+    Vehicle newVehicle;
+    if (vehicleTypeChoice == 1) {
+        newVehicle.type = LIGHT;
+        newVehicle.maxSpeed = 60.0f;
+        newVehicle.sprite.setTexture(*carTexture1);
+    } else if (vehicleTypeChoice == 2) {
+        newVehicle.type = HEAVY;
+        newVehicle.maxSpeed = 40.0f;
+        newVehicle.sprite.setTexture(*carTexture2);
+    } else {
+        newVehicle.type = EMERGENCY;
+        newVehicle.maxSpeed = 90.0f; // Faster for emergency
+        newVehicle.sprite.setTexture(*towTruckTexture); // Use tow truck texture for emergency
+    }
 
-        // Acquire ACTIVE_VEHICLES_SEM
-        if (!acquireResource(SPEED_MANAGER, ACTIVE_VEHICLES_SEM)) {
-            safePrint("[Banker] SpeedManager: Waiting for ACTIVE_VEHICLES_SEM resource.");
-            continue;
-        }
+    newVehicle.sprite.setScale(0.05f, 0.05f); // Reduced scale for better alignment
+    // Emergency vehicles run at their top speed; other drivers follow their profile
+    newVehicle.profile = sampleDriverProfile(gen);
+    newVehicle.currentSpeed = newVehicle.type == EMERGENCY ? newVehicle.maxSpeed :
+                              sampleInitialSpeed(newVehicle.profile, newVehicle.maxSpeed, gen);
+    newVehicle.numberPlate = "ABC-" + std::to_string(rand() % 9999);
+    newVehicle.spawnedAt = simClockSeconds();
+    newVehicle.laneName = lane;
+
+    // Set initial position based on lane
+    newVehicle.sprite.setPosition(lanePositions[lane]);
+    newVehicle.sprite.setRotation(laneRotations[lane]);
+    newVehicle.speedVector = laneDirections[lane];
+    return newVehicle;
+}
 
-        // Check speeds of all active vehicles
-        for (auto &vehicle : activeVehicles) {
-            if (vehicle.currentSpeed > vehicle.maxSpeed) {
-                // Detected speed violation
-                SpeedViolationMsg violationMsg;
-                std::strncpy(violationMsg.vehicleID, vehicle.numberPlate.c_str(), sizeof(violationMsg.vehicleID) - 1);
-                violationMsg.vehicleID[sizeof(violationMsg.vehicleID) - 1] = '\0';
-                violationMsg.vehicleType = vehicle.type;
-                violationMsg.speed = vehicle.currentSpeed;
-
-                if (mq_send(mqSmartToChallan, reinterpret_cast<const char*>(&violationMsg), sizeof(violationMsg), 0) == -1) {
-                    std::cerr << "[SpeedManager] Failed to send speed violation message: " << strerror(errno) << std::endl;
-                } else {
-                    safePrint("[SpeedManager] Speed violation detected for Vehicle " + vehicle.numberPlate +
-                              " Speed: " + std::to_string(vehicle.currentSpeed));
-                    totalChallansIssued++;
-                }
-            }
-        }
+// Adds a vehicle to its lane queue; the caller holds LANE_SEM
+void enqueueVehicle(const Vehicle &newVehicle) {
+    const std::string &lane = newVehicle.laneName;
 
-        // Release ACTIVE_VEHICLES_SEM
-        releaseResource(SPEED_MANAGER, ACTIVE_VEHICLES_SEM);
+    // Priority Handling: emergency front, else back
+    if (newVehicle.type == EMERGENCY) {
+        laneQueues[lane].vehicles.push_front(newVehicle);
+    } else {
+        laneQueues[lane].vehicles.push_back(newVehicle);
     }
+    laneGraph.setOccupancy(laneQueueNode(lane), static_cast<int>(laneQueues[lane].vehicles.size()));
+
+    safePrint("[SpawnVehicles] Spawned vehicle: " + newVehicle.numberPlate +
+              " Type: " + (newVehicle.type == LIGHT ? "Light" :
+                           newVehicle.type == HEAVY ? "Heavy" : "Emergency") +
+              " Driver: " + driverProfileParams(newVehicle.profile).name +
+              " Speed:" + std::to_string(newVehicle.currentSpeed) +
+              " Lane:" + newVehicle.laneName);
 }
 
-// Out-of-Order Thread
-void outOfOrderThread() {
-    // Implement out-of-order vehicle handling
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> vehicleDist(0, 100); // Probability distribution
-
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::seconds(30)); // Adjust frequency as needed
-
-        // Randomly decide if a vehicle goes out of order
-        int chance = vehicleDist(gen);
-        if (chance < 10) { // 10% chance every 30 seconds
-            // Acquire ACTIVE_VEHICLES_SEM
-            if (!acquireResource(OUT_OF_ORDER, ACTIVE_VEHICLES_SEM)) {
-                safePrint("[Banker] OutOfOrder: Waiting for ACTIVE_VEHICLES_SEM resource.");
-                continue;
-            }
-
-            if (!activeVehicles.empty()) {
-                // Select a random vehicle to go out of order
-                std::uniform_int_distribution<> selectDist(0, static_cast<int>(activeVehicles.size()) - 1);
-                int index = selectDist(gen);
-                Vehicle &vehicle = activeVehicles[index];
-                vehicle.outOfOrder = true;
-                totalVehiclesOutOfOrder++;
-
-                safePrint("[OutOfOrder] Vehicle " + vehicle.numberPlate + " has gone out of order.");
-
-                // Release ACTIVE_VEHICLES_SEM
-                releaseResource(OUT_OF_ORDER, ACTIVE_VEHICLES_SEM);
-
-                // Summon tow truck by spawning an emergency vehicle
-                std::vector<std::string> lanes = {"North1", "North2", "South1", "South2", "East1", "East2", "West1", "West2"};
-                std::uniform_int_distribution<> laneDist(0, static_cast<int>(lanes.size()) - 1);
-                std::string selectedLane = lanes[laneDist(gen)];
-
-                // Acquire LANE_SEM to modify lane queues
-                if (!acquireResource(OUT_OF_ORDER, LANE_SEM)) {
-                    safePrint("[Banker] OutOfOrder: Waiting for LANE_SEM resource to summon tow truck.");
-                    continue;
-                }
+// Seconds of hybrid simulation so far, the meso engine's clock
+double hybridSeconds() {
+    return scheduler.now();
+}
 
-                // Create tow truck vehicle
-                Vehicle towTruck;
-                towTruck.type = EMERGENCY;
-                towTruck.maxSpeed = 90.0f; // Faster than regular emergency vehicles
-                towTruck.sprite.setTexture(towTruckTexture); // Set texture properly
-                towTruck.sprite.setScale(0.05f, 0.05f); // Adjust scale as needed
-                towTruck.speedVector = sf::Vector2f(0.f, 1.f); // Moving south
-                towTruck.currentSpeed = towTruck.maxSpeed;
-                towTruck.numberPlate = "TOW-" + std::to_string(rand() % 9999);
-                towTruck.laneName = selectedLane;
-
-                // Set initial position based on lane
-                if (selectedLane.find("North") != std::string::npos) {
-                    towTruck.sprite.setPosition(400.f, 0.f);
-                    towTruck.speedVector = sf::Vector2f(0.f, 1.f);
-                }
-                else if (selectedLane.find("South") != std::string::npos) {
-                    towTruck.sprite.setPosition(400.f, 600.f);
-                    towTruck.speedVector = sf::Vector2f(0.f, -1.f);
-                }
-                else if (selectedLane.find("East") != std::string::npos) {
-                    towTruck.sprite.setPosition(800.f, 300.f);
-                    towTruck.speedVector = sf::Vector2f(-1.f, 0.f);
-                }
-                else if (selectedLane.find("West") != std::string::npos) {
-                    towTruck.sprite.setPosition(0.f, 300.f);
-                    towTruck.speedVector = sf::Vector2f(1.f, 0.f);
-                }
+// Advances the meso network to now and puts the trips it hands over into the lane queues.
+// Handoff links are sized to the queues, so a trip only waits in `pending` when a
+// lane-change rebalance has filled one side of a pair. Returns true if any trip was admitted.
+bool admitMesoHandoffs(std::vector<MesoHandoff> &pending, sf::Texture *carTexture1, sf::Texture *carTexture2,
+                       sf::Texture *towTruckTexture, std::mt19937 &gen) {
+    mesoEngine.advanceTo(hybridSeconds());
+    std::vector<MesoHandoff> handoffs = mesoEngine.takeHandoffs();
+    pending.insert(pending.end(), handoffs.begin(), handoffs.end());
+    if (pending.empty()) return false;
+
+    if (!acquireResource(SPAWN_VEHICLES, LANE_SEM)) {
+        safePrint("[Banker] SpawnVehicles: Waiting for LANE_SEM resource.");
+        return false;
+    }
 
-                // Push tow truck to the front of the lane queue
-                laneQueues[selectedLane].vehicles.push_front(towTruck);
-                activeVehicles.push_back(towTruck);
+    std::uniform_int_distribution<> typeDist(1, 3); // 1=Light,2=Heavy,3=Emergency
+    std::vector<MesoHandoff> waiting;
+    for (const auto &handoff : pending) {
+        // The trip is already on the road, so a heavy vehicle in peak hours comes in as light
+        int vehicleTypeChoice = typeDist(gen);
+        if (vehicleTypeChoice == 2 && mockTime.isPeakHours()) {
+            vehicleTypeChoice = 1;
+        }
 
-                safePrint("[OutOfOrder] Tow Truck " + towTruck.numberPlate + " summoned to lane " + selectedLane + ".");
-                
-                // Release LANE_SEM after modification
-                releaseResource(OUT_OF_ORDER, LANE_SEM);
-            } else {
-                // Release ACTIVE_VEHICLES_SEM if no vehicles are active
-                releaseResource(OUT_OF_ORDER, ACTIVE_VEHICLES_SEM);
-            }
+        // Shorter queue of the pair; heavy vehicles keep to lane 1
+        std::string lane1 = handoffApproach[handoff.link] + "1";
+        std::string lane2 = handoffApproach[handoff.link] + "2";
+        std::string lane = laneQueues[lane2].vehicles.size() < laneQueues[lane1].vehicles.size() ? lane2 : lane1;
+        if (vehicleTypeChoice == 2) {
+            lane = lane1;
+        }
+        if (static_cast<int>(laneQueues[lane].vehicles.size()) >= laneQueues[lane].maxCapacity) {
+            waiting.push_back(handoff);
+            continue;
         }
+
+        Vehicle vehicle = createVehicle(vehicleTypeChoice, lane, carTexture1, carTexture2, towTruckTexture, gen);
+        vehicle.mesoTrip = handoff.trip;
+        vehicle.mesoLink = handoff.link;
+        enqueueVehicle(vehicle);
     }
+    bool admitted = waiting.size() < pending.size();
+    pending.swap(waiting);
+
+    releaseResource(SPAWN_VEHICLES, LANE_SEM);
+    return admitted;
 }
 
-// Mock Time Thread
-void mockTimeThread() {
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::seconds(60)); // Increment time every minute
-        mockTime.incrementTime(1); // Increment by 1 minute
-        safePrint("[MockTime] Time Updated: " + std::to_string(mockTime.hour) + ":" +
-                  (mockTime.minute < 10 ? "0" : "") + std::to_string(mockTime.minute));
+// Puts a SIM_MESO_ADVANCE on the list for the meso network's next event, or sooner while
+// handed-over trips wait for a lane queue. Meso events the micro side creates, by releasing
+// or returning trips, may be earlier than the one already scheduled, which is then superseded.
+void scheduleMesoAdvance() {
+    double next = mesoEngine.nextEventTime();
+    if (!pendingHandoffs.empty()) {
+        next = std::min(next, scheduler.now() + HANDOFF_RETRY_SECONDS);
     }
+    if (next >= mesoAdvanceAt) return;
+    mesoAdvanceAt = next;
+    scheduler.schedule(next, SIM_MESO_ADVANCE, ++mesoAdvanceGeneration);
 }
 
-// Challan Generator Process
-void challanGeneratorProcess() {
-    // Open the message queue to receive speed violations
-    mqd_t mqSmartToChallanLocal = mq_open(MQ_SMART_TO_CHALLAN, O_RDONLY);
-    if (mqSmartToChallanLocal == (mqd_t)-1) {
-        std::cerr << "[ChallanGenerator] Failed to open MQ_SMART_TO_CHALLAN: " << strerror(errno) << std::endl;
-        exit(1);
+void mesoAdvanceEvent(int generation) {
+    if (generation != mesoAdvanceGeneration) return;
+    mesoAdvanceAt = std::numeric_limits<double>::infinity();
+    if (admitMesoHandoffs(pendingHandoffs, &carTexture1, &carTexture2, &towTruckTexture, simGen)) {
+        requestDischarge();
     }
+    scheduleMesoAdvance();
+}
 
-    // Open the message queue to send challan updates
-    mqd_t mqChallanToSmartLocal = mq_open(MQ_CHALLAN_TO_SMART, O_WRONLY);
-    if (mqChallanToSmartLocal == (mqd_t)-1) {
-        std::cerr << "[ChallanGenerator] Failed to open MQ_CHALLAN_TO_SMART: " << strerror(errno) << std::endl;
-        mq_close(mqSmartToChallanLocal);
-        exit(1);
+// Takes a vehicle off the road; its components go at the next flush of `world`.
+// The caller holds ACTIVE_VEHICLES_SEM.
+void removeVehicle(Entity e) {
+    Vehicle &v = world.get<Vehicle>(e);
+    if (v.mesoTrip >= 0) {
+        mesoEngine.abandonTrip(v.mesoTrip);
+        v.mesoTrip = -1;
     }
+    world.destroy(e);
+}
 
-    while (running) {
-        char buffer[sizeof(SpeedViolationMsg)];
-        ssize_t bytesRead = mq_receive(mqSmartToChallanLocal, buffer, sizeof(SpeedViolationMsg), NULL);
-        if (bytesRead >= 0) {
-            SpeedViolationMsg *msg = reinterpret_cast<SpeedViolationMsg*>(buffer);
-            std::string vehicleID(msg->vehicleID);
-            bool alreadyChallaned = false;
-
-            // Check if vehicle already has an active challan
-            if (activeChallans.find(vehicleID) != activeChallans.end()) {
-                if (activeChallans[vehicleID]) {
-                    alreadyChallaned = true;
-                }
-            }
+// Turns a discharged vehicle into an entity on the road; the caller holds ACTIVE_VEHICLES_SEM
+Entity putOnRoad(const Vehicle &vehicle) {
+    Entity e = world.create();
+    world.add<Vehicle>(e, vehicle);
+    Driving driving;
+    driving.stepFrom = vehicle.sprite.getPosition();
+    world.add<Driving>(e, driving);
+    return e;
+}
 
-            if (!alreadyChallaned) {
-                // Create a challan update message
-                ChallanUpdateMsg challanMsg;
-                std::strncpy(challanMsg.vehicleID, vehicleID.c_str(), sizeof(challanMsg.vehicleID) - 1);
-                challanMsg.vehicleID[sizeof(challanMsg.vehicleID) - 1] = '\0';
-                challanMsg.paid = false;
-
-                // Send challan to SmartTraffix
-                if (mq_send(mqChallanToSmartLocal, reinterpret_cast<const char*>(&challanMsg), sizeof(challanMsg), 0) == -1) {
-                    std::cerr << "[ChallanGenerator] Failed to send challan update: " << strerror(errno) << std::endl;
-                } else {
-                    safePrint("[ChallanGenerator] Issued challan to Vehicle " + vehicleID);
-                    activeChallans[vehicleID] = true;
-                }
-            } else {
-                safePrint("[ChallanGenerator] Vehicle " + vehicleID + " already has an active challan.");
-            }
-        } else {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                std::cerr << "[ChallanGenerator] Failed to receive message: " << strerror(errno) << std::endl;
+// Moves every driving vehicle along its lane by its step for this frame
+void integrateVehicles(Registry &registry, bool parallel) {
+    ComponentPool<Driving> &driving = registry.pool<Driving>();
+    ComponentPool<Vehicle> &vehicles = registry.pool<Vehicle>();
+    parallelForChunks(driving.size(), parallel, [&](size_t begin, size_t end) {
+        for (size_t pos = begin; pos < end; ++pos) {
+            float step = driving.valueAt(pos).step;
+            if (step > 0.f) {
+                Vehicle &v = vehicles.get(driving.entityAt(pos));
+                v.sprite.move(v.speedVector * step);
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
         }
-    }
+    });
+}
 
-    // Close message queues
-    mq_close(mqSmartToChallanLocal);
-    mq_close(mqChallanToSmartLocal);
+// True once a vehicle has driven off the edge of the window
+bool outsideWindow(const sf::Vector2f &position) {
+    return position.x < -50.f || position.x > 850.f || position.y < -50.f || position.y > 650.f;
 }
 
-// Stripe Payment Process
-void stripePaymentProcess() {
-    // Open the message queue to receive payment messages
-    mqd_t mqStripeToChallanLocal = mq_open(MQ_STRIPE_TO_CHALLAN, O_RDONLY | O_NONBLOCK);
-    if (mqStripeToChallanLocal == (mqd_t)-1) {
-        std::cerr << "[StripePayment] Failed to open MQ_STRIPE_TO_CHALLAN: " << strerror(errno) << std::endl;
-        exit(1);
+// Speed Manager
+// Violations are evaluated in the vehicle update pass; this IPC flush forwards the
+// batch collected since the last one to the challan workers.
+void flushViolations() {
+    flushPending = false;
+    // Swapped rather than moved so both buffers keep their capacity and the
+    // step's push_back does not reallocate after every flush
+    static std::vector<ViolationMsg> detected =
+        reservedBuffer<std::vector<ViolationMsg>>(MAX_PENDING_VIOLATIONS + STEP_RESERVED_VEHICLES);
+    detected.clear();
+    detected.swap(pendingViolations);
+    for (const auto &violationMsg : detected) {
+        if (sendViolation(violationMsg)) {
+            safePrint("[SpeedManager] " + violationTypeName(violationMsg.violationType) + " violation by Vehicle " +
+                      std::string(violationMsg.vehicleID) + " Speed: " + std::to_string(violationMsg.speed) +
+                      " at " + std::to_string(violationMsg.timestamp));
+        } else if (errno == EAGAIN) {
+            pendingViolations.push_back(violationMsg); // shard full: the simulation must not block on it
+        }
     }
-
-    // Open the message queue to send challan updates
-    mqd_t mqChallanToSmartLocal = mq_open(MQ_CHALLAN_TO_SMART, O_WRONLY);
-    if (mqChallanToSmartLocal == (mqd_t)-1) {
-        std::cerr << "[StripePayment] Failed to open MQ_CHALLAN_TO_SMART: " << strerror(errno) << std::endl;
-        mq_close(mqStripeToChallanLocal);
-        exit(1);
+    if (pendingViolations.size() > MAX_PENDING_VIOLATIONS) {
+        size_t dropped = pendingViolations.size() - MAX_PENDING_VIOLATIONS;
+        pendingViolations.erase(pendingViolations.begin(), pendingViolations.begin() + dropped);
+        std::cerr << "[SpeedManager] Challan queues full, dropped " << dropped << " violations." << std::endl;
     }
-
-    while (running) {
-        char buffer[sizeof(PaymentMsg)];
-        ssize_t bytesRead = mq_receive(mqStripeToChallanLocal, buffer, sizeof(PaymentMsg), NULL);
-        if (bytesRead >= 0) {
-            PaymentMsg *msg = reinterpret_cast<PaymentMsg*>(buffer);
-            std::string vehicleID(msg->vehicleID);
-            bool paid = msg->paid;
-
-            // Update challan status
-            ChallanUpdateMsg challanMsg;
-            std::strncpy(challanMsg.vehicleID, vehicleID.c_str(), sizeof(challanMsg.vehicleID) - 1);
-            challanMsg.vehicleID[sizeof(challanMsg.vehicleID) - 1] = '\0';
-            challanMsg.paid = paid;
-
-            // Send challan update to SmartTraffix
-            if (mq_send(mqChallanToSmartLocal, reinterpret_cast<const char*>(&challanMsg), sizeof(challanMsg), 0) == -1) {
-                std::cerr << "[StripePayment] Failed to send challan update: " << strerror(errno) << std::endl;
-            } else {
-                if (paid) {
-                    safePrint("[StripePayment] Vehicle " + vehicleID + " has paid the challan.");
-                    totalChallansPaid++;
-                } else {
-                    safePrint("[StripePayment] Vehicle " + vehicleID + " challan payment failed.");
-                }
-            }
-        } else {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                std::cerr << "[StripePayment] Failed to receive message: " << strerror(errno) << std::endl;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        }
+    if (!pendingViolations.empty()) {
+        flushPending = true;
+        scheduler.scheduleAfter(FLUSH_RETRY_SECONDS, SIM_VIOLATION_FLUSH);
     }
-
-    // Close message queues
-    mq_close(mqStripeToChallanLocal);
-    mq_close(mqChallanToSmartLocal);
 }
 
-// User Portal Process
-void userPortalProcess() {
-    // Open the portal status message queue for writing
-    mqd_t mqPortalStatus = mq_open(MQ_PORTAL_STATUS, O_WRONLY);
-    if (mqPortalStatus == (mqd_t)-1) {
-        std::cerr << "UserPortal: Failed to open portal status message queue." << std::endl;
-        exit(1);
-    }
+// Out-of-Order
+void breakdownEvent() {
+    std::uniform_int_distribution<> vehicleDist(0, 100); // Probability distribution
+    scheduler.scheduleAfter(BREAKDOWN_CHECK_SECONDS, SIM_BREAKDOWN);
 
-    // Open the message queue to receive challan updates
-    mqd_t mqChallanToSmartLocal = mq_open(MQ_CHALLAN_TO_SMART, O_RDONLY | O_NONBLOCK);
-    if (mqChallanToSmartLocal == (mqd_t)-1) {
-        std::cerr << "UserPortal: Failed to open MQ_CHALLAN_TO_SMART." << std::endl;
-        mq_close(mqPortalStatus);
-        exit(1);
-    }
+    // Randomly decide if a vehicle goes out of order
+    int chance = vehicleDist(simGen);
+    if (chance >= 10) return; // 10% chance every 30 seconds
 
-    // Open the message queue to send payment messages
-    mqd_t mqStripeToChallanLocal = mq_open(MQ_STRIPE_TO_CHALLAN, O_WRONLY);
-    if (mqStripeToChallanLocal == (mqd_t)-1) {
-        std::cerr << "UserPortal: Failed to open MQ_STRIPE_TO_CHALLAN." << std::endl;
-        mq_close(mqPortalStatus);
-        mq_close(mqChallanToSmartLocal);
-        exit(1);
+    // Acquire ACTIVE_VEHICLES_SEM
+    if (!acquireResource(OUT_OF_ORDER, ACTIVE_VEHICLES_SEM)) {
+        safePrint("[Banker] OutOfOrder: Waiting for ACTIVE_VEHICLES_SEM resource.");
+        return;
     }
 
-    // Send 'active' status before opening the portal
-    PortalStatusMsg activeMsg;
-    std::strncpy(activeMsg.status, "active", sizeof(activeMsg.status) - 1);
-    activeMsg.status[sizeof(activeMsg.status) - 1] = '\0';
-    if (mq_send(mqPortalStatus, reinterpret_cast<const char*>(&activeMsg), sizeof(activeMsg), 0) == -1) {
-        std::cerr << "UserPortal: Failed to send 'active' status." << std::endl;
+    ComponentPool<Driving> &driving = world.pool<Driving>();
+    if (driving.size() > 0) {
+        // Select a random moving vehicle to go out of order
+        std::uniform_int_distribution<> selectDist(0, static_cast<int>(driving.size()) - 1);
+        Entity e = driving.entityAt(selectDist(simGen));
+        if (world.alive(e)) {
+            Vehicle &vehicle = world.get<Vehicle>(e);
+            world.remove<Driving>(e);
+            world.add<Breakdown>(e, Breakdown());
+            totalVehiclesOutOfOrder++;
+
+            safePrint("[OutOfOrder] Vehicle " + vehicle.numberPlate + " has gone out of order.");
+
+            // Report the breakdown; the dispatcher sends the nearest free tow truck to it
+            // and keeps the lane blocked until the vehicle has been hauled away
+            sf::Vector2f position = vehicle.sprite.getPosition();
+            dispatcher.reportIncident(vehicle.numberPlate, vehicle.laneName, position.x, position.y);
+            requestFrame();
+        }
     }
 
-    // User interaction loop
-    while (running) {
-        std::cout << "\n--- User Portal ---\n";
-        std::cout << "1. View Challans\n2. Pay Challan\n3. Exit\nEnter choice: ";
-        int choice;
-        std::cin >> choice;
-
-        if (!running) break;
-
-        if (choice == 1) {
-            std::cout << "\n--- Active Challans ---\n";
-            // Acquire ACTIVE_VEHICLES_SEM to access challans
-            if (!acquireResource(USER_PORTAL, ACTIVE_VEHICLES_SEM)) {
-                safePrint("[Banker] UserPortal: Waiting for ACTIVE_VEHICLES_SEM resource.");
-                continue;
-            }
-
-            bool hasChallans = false;
-            for (const auto &entry : activeChallans) {
-                if (entry.second) { // If challan is active
-                    std::cout << "Vehicle ID: " << entry.first << " | Paid: No\n";
-                    hasChallans = true;
-                }
-            }
-
-            if (!hasChallans) {
-                std::cout << "No active challans.\n";
-            }
+    // Release ACTIVE_VEHICLES_SEM
+    releaseResource(OUT_OF_ORDER, ACTIVE_VEHICLES_SEM);
+}
 
-            // Release ACTIVE_VEHICLES_SEM
-            releaseResource(USER_PORTAL, ACTIVE_VEHICLES_SEM);
-        }
-        else if (choice == 2) {
-            std::cout << "Enter Vehicle ID to pay challan: ";
-            std::string vid;
-            std::cin >> vid;
+// Mock Time
+void mockTimeEvent() {
+    scheduler.scheduleAfter(MOCK_MINUTE_SECONDS, SIM_CLOCK_TICK);
+    mockTime.incrementTime(1); // Increment by 1 minute
+    safePrint("[MockTime] Time Updated: " + std::to_string(mockTime.hour) + ":" +
+              (mockTime.minute < 10 ? "0" : "") + std::to_string(mockTime.minute));
+}
 
-            // Check if challan exists
-            bool challanExists = false;
-            {
-                std::lock_guard<std::mutex> lock(printMutex); // Protect access
-                if (activeChallans.find(vid) != activeChallans.end() && activeChallans[vid]) {
-                    challanExists = true;
-                }
-            }
+// Map a number plate to its challan worker (FNV-1a, stable across processes)
+int challanShardFor(const std::string &plate) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : plate) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return static_cast<int>(hash % static_cast<uint32_t>(numChallanWorkers));
+}
 
-            if (challanExists) {
-                // Create payment message
-                PaymentMsg paymentMsg;
-                std::strncpy(paymentMsg.vehicleID, vid.c_str(), sizeof(paymentMsg.vehicleID) - 1);
-                paymentMsg.vehicleID[sizeof(paymentMsg.vehicleID) - 1] = '\0';
-                paymentMsg.paid = true;
-
-                // Send payment message to StripePayment
-                if (mq_send(mqStripeToChallanLocal, reinterpret_cast<const char*>(&paymentMsg), sizeof(paymentMsg), 0) == -1) {
-                    std::cerr << "UserPortal: Failed to send payment message." << std::endl;
-                } else {
-                    std::cout << "Challan for Vehicle ID " << vid << " has been submitted for payment.\n";
-                }
-            } else {
-                std::cout << "No active challan found for Vehicle ID " << vid << ".\n";
-            }
-        }
-        else if (choice == 3) {
-            std::cout << "Exiting User Portal.\n";
-            break;
-        }
-        else {
-            std::cout << "Invalid choice. Try again.\n";
-        }
+// Path of a child executable installed next to this one
+std::string siblingExecutable(const char *name) {
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) {
+        return std::string("./") + name;
+    }
+    std::string path(self, static_cast<size_t>(length));
+    return path.substr(0, path.rfind('/') + 1) + name;
+}
 
-        // Process any incoming challan updates
-        char buffer[sizeof(ChallanUpdateMsg)];
-        ssize_t bytesRead = mq_receive(mqChallanToSmartLocal, buffer, sizeof(ChallanUpdateMsg), NULL);
-        if (bytesRead >= 0) {
-            ChallanUpdateMsg *msg = reinterpret_cast<ChallanUpdateMsg*>(buffer);
-            std::string vehicleID(msg->vehicleID);
-            bool paid = msg->paid;
+// Collision system: sweeps each vehicle's box along its last step so a long step
+// cannot carry one vehicle through another between frames. Broken vehicles stand still.
+size_t collisionSystem() {
+    static std::vector<SweptBox> boxes = reservedBuffer<std::vector<SweptBox>>();
+    static std::vector<Entity> boxVehicles = reservedBuffer<std::vector<Entity>>();
+    static std::vector<CollisionPair> collisions = reservedBuffer<std::vector<CollisionPair>>();
+    boxes.clear();
+    boxVehicles.clear();
+    world.each<Vehicle>([&](Entity e, Vehicle &v) {
+        sf::FloatRect bounds = v.sprite.getGlobalBounds();
+        Driving *driving = world.find<Driving>(e);
+        sf::Vector2f motion = driving ? v.sprite.getPosition() - driving->stepFrom : sf::Vector2f(0.f, 0.f);
+        boxes.push_back({bounds.left - motion.x, bounds.top - motion.y,
+                         bounds.left + bounds.width - motion.x, bounds.top + bounds.height - motion.y,
+                         motion.x, motion.y});
+        boxVehicles.push_back(e);
+    });
+    findSweptCollisions(boxes, collisions, &stepArena);
 
-            if (paid) {
-                // Update challan status
-                std::lock_guard<std::mutex> lock(printMutex);
-                activeChallans[vehicleID] = false;
-                totalChallansPaid++;
-                std::cout << "[UserPortal] Challan for Vehicle " << vehicleID << " has been paid.\n";
-            } else {
-                // Handle failed payment or other statuses if needed
-                std::cout << "[UserPortal] Challan update for Vehicle " << vehicleID << " received.\n";
-            }
-        }
+    // Earliest contacts first: a vehicle stops at its first collision
+    for (const CollisionPair &pair : collisions) {
+        Entity a = boxVehicles[pair.a];
+        Entity b = boxVehicles[pair.b];
+        if (!world.alive(a) || !world.alive(b))
+            continue;
+        safePrintf("[CollisionHandler] Collision detected between Vehicle %s and Vehicle %s.",
+                   world.get<Vehicle>(a).numberPlate.c_str(), world.get<Vehicle>(b).numberPlate.c_str());
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    }
+        // Take both vehicles off the road
+        removeVehicle(a);
+        removeVehicle(b);
 
-    // Send 'inactive' status after closing the portal
-    PortalStatusMsg inactiveMsg;
-    std::strncpy(inactiveMsg.status, "inactive", sizeof(inactiveMsg.status) - 1);
-    inactiveMsg.status[sizeof(inactiveMsg.status) - 1] = '\0';
-    if (mq_send(mqPortalStatus, reinterpret_cast<const char*>(&inactiveMsg), sizeof(inactiveMsg), 0) == -1) {
-        std::cerr << "UserPortal: Failed to send 'inactive' status." << std::endl;
+        // Increment analytics counter
+        // For simplicity, we can consider them out of order
+        totalVehiclesOutOfOrder += 2;
     }
-
-    // Close message queues
-    mq_close(mqPortalStatus);
-    mq_close(mqChallanToSmartLocal);
-    mq_close(mqStripeToChallanLocal);
+    return boxes.size();
 }
 
-// Handle Collisions and Cleanup
-void handleCollisionsAndCleanup() {
-    // Acquire ACTIVE_VEHICLES_SEM to access activeVehicles
-    if (!acquireResource(TRAFFIC_LIGHT_CONTROLLER, ACTIVE_VEHICLES_SEM)) {
-        safePrint("[Banker] CollisionHandler: Waiting for ACTIVE_VEHICLES_SEM resource.");
+// Balance Paired Lane Queues
+// Waiting vehicles at the back of the longer queue of a pair move to the shorter one
+void balanceLaneQueues() {
+    if (!acquireResource(TRAFFIC_LIGHT_CONTROLLER, LANE_SEM)) {
         return;
     }
 
-    // Check for collisions between vehicles
-    for (size_t i = 0; i < activeVehicles.size(); ++i) {
-        for (size_t j = i + 1; j < activeVehicles.size(); ++j) {
-            if (activeVehicles[i].isTowed || activeVehicles[j].isTowed)
-                continue; // Skip if either vehicle is being towed
-
-            if (activeVehicles[i].sprite.getGlobalBounds().intersects(activeVehicles[j].sprite.getGlobalBounds())) {
-                // Collision detected
-                std::string vehicleA = activeVehicles[i].numberPlate;
-                std::string vehicleB = activeVehicles[j].numberPlate;
-                safePrint("[CollisionHandler] Collision detected between Vehicle " + vehicleA + " and Vehicle " + vehicleB + ".");
-
-                // Remove both vehicles from activeVehicles
-                activeVehicles[i].isTowed = true;
-                activeVehicles[j].isTowed = true;
-
-                // Increment analytics counter
-                // For simplicity, we can consider them out of order
-                totalVehiclesOutOfOrder += 2;
-            }
-        }
+    for (auto &entry : laneQueues) {
+        const std::string &lane = entry.first;
+        if (lane.back() != '1') continue; // visit each pair once
+        std::string pair = adjacentLane(lane);
+        std::deque<Vehicle> &a = entry.second.vehicles;
+        std::deque<Vehicle> &b = laneQueues[pair].vehicles;
+
+        std::deque<Vehicle> &longer = a.size() > b.size() ? a : b;
+        std::deque<Vehicle> &shorter = a.size() > b.size() ? b : a;
+        const std::string &target = a.size() > b.size() ? pair : lane;
+        if (longer.size() < shorter.size() + 2 || longer.back().type == EMERGENCY) continue;
+        // Heavy vehicles stay out of the restricted lane, as at spawn
+        if (longer.back().type == HEAVY && target.back() == HEAVY_RESTRICTED_LANE) continue;
+
+        Vehicle moved = longer.back();
+        longer.pop_back();
+        moved.laneName = target;
+        moved.sprite.setPosition(lanePositions[target]);
+        shorter.push_back(moved);
+        laneGraph.setOccupancy(laneQueueNode(lane), static_cast<int>(a.size()));
+        laneGraph.setOccupancy(laneQueueNode(pair), static_cast<int>(b.size()));
     }
 
-    // Remove towed vehicles from activeVehicles
-    activeVehicles.erase(
-        std::remove_if(activeVehicles.begin(), activeVehicles.end(),
-                       [](const Vehicle &v) { return v.isTowed; }),
-        activeVehicles.end());
-
-    // Release ACTIVE_VEHICLES_SEM
-    releaseResource(TRAFFIC_LIGHT_CONTROLLER, ACTIVE_VEHICLES_SEM);
+    releaseResource(TRAFFIC_LIGHT_CONTROLLER, LANE_SEM);
 }
 
 // Process Queues
-void processQueues() {
-    // Iterate through each lane and move vehicles to activeVehicles based on traffic light state
+// Releases at most one vehicle per lane. Returns true while vehicles still wait on a
+// green approach, so another discharge is due next frame.
+bool processQueues() {
+    if (laneChangesEnabled) {
+        balanceLaneQueues();
+    }
+
+    // One SPaT snapshot serves every lane this pass
+    std::shared_ptr<const SpatMessage> spat = spatBus.current();
+    if (!spat) return false;
+    bool waiting = false;
+
+    // Iterate through each lane and move vehicles onto the road based on traffic light state
     for (auto &entry : laneQueues) {
         std::string lane = entry.first;
         LaneQueue &queue = entry.second;
@@ -866,137 +1105,699 @@ void processQueues() {
             direction = "West";
         }
 
+        // Hold the queue while the lane ahead has spilled back or its entry is still occupied
+        bool green = spat->state[spatApproachIndex(direction)] == GREEN;
+        bool entryClear = laneTailProgress.find(lane) == laneTailProgress.end() || laneTailProgress[lane] > MIN_GAP;
+        if (laneGraph.isHeld(laneQueueNode(lane)) || !entryClear) {
+            waiting = waiting || (green && !queue.vehicles.empty());
+            continue;
+        }
+
         // Check if traffic light for this direction is GREEN
-        if (trafficLights[direction].state == GREEN) {
-            // Move vehicle from queue to activeVehicles
+        if (green) {
+            // Move vehicle from queue onto the road
             if (!queue.vehicles.empty()) {
-                // Acquire ACTIVE_VEHICLES_SEM to modify activeVehicles
+                // Acquire ACTIVE_VEHICLES_SEM to add to the vehicles on the road
                 if (!acquireResource(TRAFFIC_LIGHT_CONTROLLER, ACTIVE_VEHICLES_SEM)) {
                     safePrint("[Banker] processQueues: Waiting for ACTIVE_VEHICLES_SEM resource.");
+                    waiting = true;
                     continue;
                 }
 
                 Vehicle vehicle = queue.vehicles.front();
                 queue.vehicles.pop_front();
-                activeVehicles.push_back(vehicle);
+                putOnRoad(vehicle);
+                laneGraph.setOccupancy(laneQueueNode(lane), static_cast<int>(queue.vehicles.size()));
+                laneTailProgress[lane] = 0.f;
+                if (vehicle.mesoLink >= 0) {
+                    // Its place on the meso handoff link is free again
+                    mesoEngine.releaseHandoff(vehicle.mesoLink);
+                }
+                vehiclesDischarged++;
 
                 safePrint("[processQueues] Vehicle " + vehicle.numberPlate + " entered traffic from lane " + lane + ".");
 
                 // Release ACTIVE_VEHICLES_SEM after modification
                 releaseResource(TRAFFIC_LIGHT_CONTROLLER, ACTIVE_VEHICLES_SEM);
             }
+            waiting = waiting || !queue.vehicles.empty();
         }
     }
+    return waiting;
 }
 
-// Deadlock Prevention Loop
-void runDeadlockPrevention() {
-    // Implement deadlock prevention using Banker's algorithm
-    // In this implementation, resource requests and releases are handled within each thread/process
-    // Therefore, this function can remain empty or perform periodic checks
-    while (running) {
-        // For demonstration, just sleep
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+// Schedules the next frame on the stepSeconds grid unless one is already on the list
+void requestFrame() {
+    if (framePending) return;
+    framePending = true;
+    scheduler.schedule(std::max(scheduler.now(), lastFrameAt + stepSeconds), SIM_FRAME);
+}
+
+// Schedules a queue discharge now unless one is already on the list
+void requestDischarge() {
+    if (dischargePending) return;
+    dischargePending = true;
+    scheduler.schedule(scheduler.now(), SIM_DISCHARGE);
+}
+
+// Lane discharge: repeats every frame while vehicles wait on a green approach,
+// and otherwise waits for the next spawn or green to request it
+void dischargeEvent() {
+    dischargePending = false;
+    int dischargedBefore = vehiclesDischarged;
+    bool waiting = processQueues();
+    if (vehiclesDischarged != dischargedBefore) {
+        requestFrame();
+    }
+    if (waiting) {
+        dischargePending = true;
+        scheduler.scheduleAfter(stepSeconds, SIM_DISCHARGE);
+    }
+    if (hybridMode) {
+        scheduleMesoAdvance(); // released handoffs may let meso trips move
+    }
+}
+
+// Something on the road still moves: a vehicle, or a tow truck out on a job
+bool roadBusy() {
+    if (world.pool<Vehicle>().size() > 0) return true;
+    for (const auto &unit : dispatcher.getTowUnits()) {
+        if (unit.state != TOW_AVAILABLE) return true;
     }
+    return false;
+}
+
+// One simulation step and redraw; frames keep coming while the road is busy
+void frameEvent(sf::RenderWindow &window, sf::Sprite &roadSprite, sf::Text &analyticsText) {
+    framePending = false;
+    lastFrameAt = scheduler.now();
+    pollWindowEvents(window);
+    drainPaymentReports();
+    visualizeTraffic(window, roadSprite, analyticsText);
+    if (hybridMode) {
+        scheduleMesoAdvance(); // trips leaving the window re-enter the grid
+    }
+    if (roadBusy()) {
+        requestFrame();
+    }
+}
+
+// Counts the payments StripePayment has settled since the last frame and forwards each
+// to the challan worker owning the plate, so its ledger closes the challan. A full shard
+// queue keeps the settlement for the next frame.
+void drainPaymentReports() {
+    if (mqStripeToSmart == (mqd_t)-1) return;
+    static std::vector<PaymentMsg> settlements;
+    char buffer[MQ_MAX_SIZE]; // mq_receive needs room for the queue's full message size
+    while (mq_receive(mqStripeToSmart, buffer, sizeof(buffer), NULL) >= 0) {
+        const PaymentMsg *payment = reinterpret_cast<PaymentMsg*>(buffer);
+        if (payment->paid) {
+            totalChallansPaid++;
+            settlements.push_back(*payment);
+        }
+    }
+
+    size_t kept = 0;
+    for (const auto &payment : settlements) {
+        mqd_t shardQueue = mqSmartToChallanShards[challanShardFor(payment.vehicleID)];
+        if (mq_send(shardQueue, reinterpret_cast<const char*>(&payment), sizeof(payment), 0) == -1) {
+            if (errno == EAGAIN) {
+                settlements[kept++] = payment;
+            } else {
+                std::cerr << "[SmartTraffix] Failed to forward payment: " << strerror(errno) << std::endl;
+            }
+        }
+    }
+    settlements.resize(kept);
+}
+
+// Window events, handled between simulation events
+void pollWindowEvents(sf::RenderWindow &window) {
+    sf::Event event;
+    while (window.pollEvent(event)) {
+        if (event.type == sf::Event::Closed) {
+            window.close(); // runSimulation returns and main() cleans up
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::L) {
+            // Toggle lane changes and restart the throughput measurement
+            laneChangesEnabled = !laneChangesEnabled;
+            vehiclesDischarged = 0;
+            tripsCompleted = 0;
+            totalTravelTime = 0.0;
+            throughputSince = simClockSeconds();
+            requestFrame();
+        }
+        else if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus) {
+            requestFrame(); // repaint even if nothing is moving
+        }
+    }
+}
+
+// Event loop: seeds the recurring events, then runs handlers in time order until the
+// window closes. In real time the scheduler sleeps until each event is due.
+void runSimulation(sf::RenderWindow &window, sf::Sprite &roadSprite, sf::Text &analyticsText) {
+    if (hybridMode) {
+        scheduleMesoAdvance(); // vehicles arrive from the meso network instead of at random
+    } else {
+        scheduler.scheduleAfter(spawnInterval, SIM_SPAWN);
+    }
+    scheduler.schedule(greenStartedAt + MIN_GREEN_SECONDS, SIM_SIGNAL);
+    scheduler.scheduleAfter(BREAKDOWN_CHECK_SECONDS, SIM_BREAKDOWN);
+    scheduler.scheduleAfter(MOCK_MINUTE_SECONDS, SIM_CLOCK_TICK);
+    scheduler.scheduleAfter(0.0, SIM_WINDOW_POLL);
+    requestFrame();
+    scheduler.setRealTime(!fastMode);
+
+    SimEvent event;
+    while (running && window.isOpen() && scheduler.next(event)) {
+        switch (event.type) {
+            case SIM_SPAWN: spawnVehicleEvent(); break;
+            case SIM_SIGNAL: signalControllerEvent(); break;
+            case SIM_DISCHARGE: dischargeEvent(); break;
+            case SIM_FRAME: frameEvent(window, roadSprite, analyticsText); break;
+            case SIM_BREAKDOWN: breakdownEvent(); break;
+            case SIM_CLOCK_TICK: mockTimeEvent(); break;
+            case SIM_VIOLATION_FLUSH: flushViolations(); break;
+            case SIM_MESO_ADVANCE: mesoAdvanceEvent(event.target); break;
+            case SIM_WINDOW_POLL:
+                pollWindowEvents(window);
+                scheduler.scheduleAfter(WINDOW_POLL_SECONDS, SIM_WINDOW_POLL);
+                break;
+        }
+    }
+}
+
+// Movement system: car following, lane changes and stop lines along each lane, front
+// to back, then every driving vehicle's step applied at once. Fills `laneFronts` with
+// the vehicle fronts per lane after the step, for the loop detectors.
+size_t movementSystem(const SpatMessage &spat, float dt, LaneFronts &laneFronts) {
+    // Order each lane's vehicles front to back so every vehicle can see the one ahead,
+    // and find the rear-most broken vehicle blocking each lane
+    static std::vector<Entity> onRoad = reservedBuffer<std::vector<Entity>>();
+    static std::vector<float> progress = reservedBuffer<std::vector<float>>();
+    onRoad.clear();
+    progress.clear();
+    std::pmr::map<std::string, std::pmr::vector<size_t>> laneOrder(&stepArena);
+    std::pmr::map<std::string, float> laneBlockage(&stepArena);
+    std::pmr::map<std::string, int> laneOccupancy(&stepArena);
+    world.each<Vehicle>([&](Entity e, Vehicle &v) {
+        laneOrder[v.laneName].push_back(onRoad.size());
+        onRoad.push_back(e);
+        progress.push_back(laneProgress(v));
+    });
+    world.each<Breakdown, Vehicle>([&](Entity, Breakdown &, Vehicle &v) {
+        float at = laneProgress(v);
+        auto block = laneBlockage.find(v.laneName);
+        if (block == laneBlockage.end() || at < block->second) {
+            laneBlockage[v.laneName] = at;
+        }
+    });
+    // Only vehicles behind a blockage fill the space it leaves; those already past it drive on
+    world.each<Driving, Vehicle>([&](Entity, Driving &, Vehicle &v) {
+        auto block = laneBlockage.find(v.laneName);
+        if (block == laneBlockage.end() || laneProgress(v) < block->second) {
+            laneOccupancy[v.laneName]++;
+        }
+    });
+    for (auto &entry : laneOrder) {
+        std::sort(entry.second.begin(), entry.second.end(),
+                  [&](size_t a, size_t b) { return progress[a] > progress[b]; });
+    }
+
+    // An incident cuts a lane's capacity to the vehicles that fit behind it. The graph
+    // is one hop deep (each lane's queue feeds only that lane), so a spilled-back lane
+    // holds its own queue and nothing further; spawning then stops once that queue fills
+    for (const auto &entry : lanePositions) {
+        const std::string &lane = entry.first;
+        auto block = laneBlockage.find(lane);
+        if (block != laneBlockage.end()) {
+            laneGraph.setBlocked(lane, true, std::max(0, static_cast<int>(block->second / VEHICLE_SPACING)));
+        } else {
+            laneGraph.setBlocked(lane, false, 0);
+        }
+        laneGraph.setOccupancy(lane, laneOccupancy[lane]);
+    }
+    laneGraph.propagate();
+
+    // Driver speed processes: gather the moving vehicles, advance them together, scatter back
+    static SpeedProcessBatch speedProcesses = reservedBuffer<SpeedProcessBatch>();
+    static std::vector<Vehicle *> speedProcessVehicles = reservedBuffer<std::vector<Vehicle *>>();
+    static std::mt19937 speedGen(std::random_device{}());
+    speedProcesses.clear();
+    speedProcessVehicles.clear();
+    world.each<Driving, Vehicle>([&](Entity, Driving &, Vehicle &v) {
+        if (v.type == EMERGENCY) return;
+        speedProcesses.add(v.currentSpeed, v.profile, v.maxSpeed);
+        speedProcessVehicles.push_back(&v);
+    });
+    updateSpeedProcesses(speedProcesses, dt, speedGen);
+    for (size_t i = 0; i < speedProcessVehicles.size(); ++i) {
+        speedProcessVehicles[i]->currentSpeed = speedProcesses.speed[i];
+    }
+
+    // Front-to-back slots per lane for the lane-change gap search
+    std::pmr::map<std::string, LaneSlots> laneSlots(&stepArena);
+    for (const auto &entry : laneOrder) {
+        LaneSlots &slots = laneSlots[entry.first];
+        for (size_t idx : entry.second) {
+            const Driving *driving = world.find<Driving>(onRoad[idx]);
+            slots.push_back({progress[idx], driving ? driving->realizedSpeed : 0.f});
+        }
+    }
+
+    for (auto &entry : laneOrder) {
+        const std::string lane = entry.first;
+        TrafficLightState light = static_cast<TrafficLightState>(spat.state[spatApproachIndex(laneApproach(lane))]);
+        float leaderProgress = std::numeric_limits<float>::max();
+        bool leaderBroken = false;
+        laneTailProgress[lane] = std::numeric_limits<float>::max();
+
+        for (size_t idx : entry.second) {
+            Vehicle &v = world.get<Vehicle>(onRoad[idx]);
+            Driving *d = world.find<Driving>(onRoad[idx]);
+            if (!d) {
+                // Broken vehicles stay where they stopped until a tow truck hauls them away
+                leaderProgress = progress[idx];
+                leaderBroken = true;
+                laneFronts[lane].push_back(progress[idx]);
+                continue;
+            }
+            d->stepFrom = v.sprite.getPosition();
+            d->fromProgress = progress[idx];
+            d->step = 0.f;
+            d->changedLaneByChoice = false;
+
+            float room = leaderProgress - MIN_GAP - progress[idx];
+
+            // MOBIL lane change into the paired lane. Closing on a breakdown makes the
+            // change mandatory, so only the gap and safety tests apply.
+            bool mandatory = leaderBroken && room < MERGE_LOOKAHEAD;
+            if (d->laneChangeCooldown > 0.f) {
+                d->laneChangeCooldown -= dt;
+            }
+            else if (laneChangesEnabled || mandatory) {
+                std::string target = adjacentLane(lane);
+                LaneSlots &ownSlots = laneSlots[lane];
+                LaneSlots &targetSlots = laneSlots[target];
+                size_t self = findFollower(ownSlots, progress[idx]);
+                float desiredSpeed = v.type == EMERGENCY ? v.maxSpeed :
+                                     driverProfileParams(v.profile).desiredRatio * v.maxSpeed;
+                if (mobilShouldChange(ownSlots, self, desiredSpeed, targetSlots, mandatory, idmParams, mobilParams)) {
+                    sf::Vector2f shift = lanePositions[target] - lanePositions[lane];
+                    const sf::Vector2f &dir = laneDirections[lane];
+                    float along = shift.x * dir.x + shift.y * dir.y;
+                    v.sprite.move(shift.x - dir.x * along, shift.y - dir.y * along);
+                    v.laneName = target;
+                    d->laneChangeCooldown = LANE_CHANGE_COOLDOWN_SECONDS;
+                    d->changedLaneByChoice = !mandatory;
+
+                    // Move the slot at once so later decisions this frame see the new gap
+                    LaneSlot slot = ownSlots[self];
+                    ownSlots.erase(ownSlots.begin() + self);
+                    targetSlots.insert(targetSlots.begin() + findFollower(targetSlots, slot.progress), slot);
+
+                    safePrintf("[LaneChange] Vehicle %s moved from %s to %s.",
+                               v.numberPlate.c_str(), lane.c_str(), target.c_str());
+                    laneFronts[target].push_back(progress[idx]);
+                    continue;
+                }
+            }
+
+            // Stop at the stop line unless green, or already committed to the junction.
+            // Emergency vehicles have priority and do not stop.
+            float toStopLine = laneStopDistances[lane] - progress[idx];
+            if (toStopLine <= 0.f || light == GREEN) {
+                // Past the stop line, or a fresh green: the next amber is a new decision
+                d->committed = false;
+            } else if (v.type != EMERGENCY) {
+                // Only a vehicle still moving when amber finds it in the zone cannot stop
+                if (light == YELLOW && toStopLine <= DILEMMA_ZONE && d->realizedSpeed > 0.f) {
+                    d->committed = true;
+                }
+                if (!d->committed) {
+                    room = std::min(room, toStopLine - 1.f);
+                }
+            }
+
+            // Step along the lane at the vehicle's speed, never closer than MIN_GAP to the vehicle ahead
+            float step = std::max(0.f, std::min(v.currentSpeed * SPEED_TO_PIXELS_PER_SEC * dt, room));
+            d->step = step;
+            d->realizedSpeed = step / (SPEED_TO_PIXELS_PER_SEC * dt);
+            progress[idx] += step;
+            leaderProgress = progress[idx];
+            leaderBroken = false;
+
+            // Vehicles leaving the window this step are retired by the exit system
+            if (outsideWindow(v.sprite.getPosition() + v.speedVector * step)) {
+                continue;
+            }
+            laneTailProgress[lane] = progress[idx];
+            laneFronts[lane].push_back(progress[idx]);
+        }
+    }
+
+    integrateVehicles(world, parallelStep);
+    return onRoad.size();
+}
+
+// Violation system: wrong-lane changes, speeding, red-light running and average speed
+// over the section, judged from the step the movement system just took
+size_t violationSystem(const SpatMessage &spat, double stepStartWall, double stepWall) {
+    // Violations raised during this step, handed to the next IPC flush in one batch
+    static std::vector<ViolationMsg> stepViolations = reservedBuffer<std::vector<ViolationMsg>>();
+    stepViolations.clear();
+
+    // Each moving vehicle's step, checked against its stop line after the pass
+    static CrossingBatch crossings = reservedBuffer<CrossingBatch>();
+    static std::vector<Entity> crossingVehicles = reservedBuffer<std::vector<Entity>>();
+    static std::vector<float> crossingFractions = reservedBuffer<std::vector<float>>();
+    crossings.clear();
+    crossingVehicles.clear();
+
+    size_t visited = world.each<Driving, Vehicle>([&](Entity e, Driving &d, Vehicle &v) {
+        // Wrong lane: a heavy vehicle moving into the restricted lane by choice
+        if (d.changedLaneByChoice && v.type == HEAVY && v.laneName.back() == HEAVY_RESTRICTED_LANE) {
+            stepViolations.push_back(makeViolation(v, WRONG_LANE, d.realizedSpeed, stepWall));
+            totalWrongLaneViolations++;
+        }
+
+        // Speeding: raised once when the vehicle goes over its limit, not on every step.
+        // Judged on the speed actually driven this step; currentSpeed is only the
+        // driver's desired speed, which keeps wandering while queued at a red light.
+        bool overLimit = v.type != EMERGENCY && d.realizedSpeed > v.maxSpeed;
+        if (overLimit && !d.speeding) {
+            stepViolations.push_back(makeViolation(v, SPEEDING, d.realizedSpeed, stepWall));
+            totalSpeedingViolations++;
+            d.speeding = true;
+        } else if (d.realizedSpeed < v.maxSpeed * SPEEDING_REARM_RATIO) {
+            d.speeding = false;
+        }
+
+        if (d.step <= 0.f) return;
+        if (v.type != EMERGENCY) {
+            sf::Vector2f after = v.sprite.getPosition();
+            crossings.add(d.stepFrom.x, d.stepFrom.y, after.x, after.y, laneStopLines[v.laneName]);
+            crossingVehicles.push_back(e);
+        }
+
+        // Section control: a camera reads the plate when the vehicle passes it, timed
+        // by where along this step the camera position falls
+        float fromProgress = d.fromProgress;
+        float toProgress = d.fromProgress + d.step;
+        std::string approach = laneApproach(v.laneName);
+        float exitCamera = sectionExitCameras[approach];
+        if (fromProgress < SECTION_ENTRY_CAMERA && toProgress >= SECTION_ENTRY_CAMERA) {
+            float frac = (SECTION_ENTRY_CAMERA - fromProgress) / d.step;
+            sectionControl.entryRead(v.numberPlate, approach, stepStartWall + frac * (stepWall - stepStartWall));
+        }
+        SectionPassage passage;
+        if (fromProgress < exitCamera && toProgress >= exitCamera &&
+            sectionControl.exitRead(v.numberPlate, approach,
+                                    stepStartWall + (exitCamera - fromProgress) / d.step * (stepWall - stepStartWall),
+                                    passage)) {
+            float averageSpeed = passage.averageSpeed / SPEED_TO_PIXELS_PER_SEC;
+            if (v.type != EMERGENCY && averageSpeed > v.maxSpeed) {
+                stepViolations.push_back(makeViolation(v, AVERAGE_SPEED, averageSpeed, passage.exitTime));
+                totalAverageSpeedViolations++;
+            }
+        }
+    });
+
+    // Red-light running: swept test of every step against its stop line, then
+    // interpolate the exact crossing time within the step
+    sweptStopLineCrossings(crossings, crossingFractions);
+    for (size_t i = 0; i < crossingVehicles.size(); ++i) {
+        if (crossingFractions[i] < 0.f) continue;
+        const Vehicle &v = world.get<Vehicle>(crossingVehicles[i]);
+        if (spat.state[spatApproachIndex(laneApproach(v.laneName))] != RED) continue;
+
+        const Driving &d = world.get<Driving>(crossingVehicles[i]);
+        stepViolations.push_back(makeViolation(v, RED_LIGHT, d.realizedSpeed,
+                                               stepStartWall + crossingFractions[i] * (stepWall - stepStartWall)));
+        totalRedLightViolations++;
+    }
+
+    // Queue this step's violations for an IPC flush
+    if (!stepViolations.empty()) {
+        pendingViolations.insert(pendingViolations.end(), stepViolations.begin(), stepViolations.end());
+        if (!flushPending) {
+            flushPending = true;
+            scheduler.schedule(scheduler.now(), SIM_VIOLATION_FLUSH);
+        }
+    }
+    return visited;
+}
+
+// Exit system: vehicles that have driven out of the window finish their trip
+size_t exitSystem(double stepWall) {
+    return world.each<Driving, Vehicle>([&](Entity e, Driving &d, Vehicle &v) {
+        if (!outsideWindow(v.sprite.getPosition())) return;
+
+        safePrintf("[visualizeTraffic] Vehicle %s has exited the simulation.", v.numberPlate.c_str());
+        tripsCompleted++;
+        totalTravelTime += stepWall - v.spawnedAt;
+        if (v.mesoTrip >= 0) {
+            // Back to the meso grid, straight on from the approach it came in on
+            int exitLink = mesoEngine.gridExitLink(hybridRow, hybridCol, approachDirection[laneApproach(v.laneName)]);
+            mesoEngine.returnTrip(v.mesoTrip, exitLink, hybridSeconds(),
+                                  (d.fromProgress + d.step) / (v.maxSpeed * SPEED_TO_PIXELS_PER_SEC));
+            v.mesoTrip = -1;
+        }
+        // Find and remove vehicle from laneQueues if necessary
+        for (auto &laneEntry : laneQueues) {
+            auto &laneQueue = laneEntry.second.vehicles;
+            laneQueue.erase(std::remove_if(laneQueue.begin(), laneQueue.end(),
+                [&](const Vehicle &laneV) { return laneV.numberPlate == v.numberPlate; }),
+                laneQueue.end());
+        }
+        removeVehicle(e);
+    });
+}
+
+// Render extraction: signal heads in their SPaT colour, the vehicles on the road and the tow trucks
+size_t renderSystem(sf::RenderWindow &window, const SpatMessage &spat) {
+    size_t drawn = world.each<SignalHead>([&](Entity, SignalHead &head) {
+        int state = spat.state[spatApproachIndex(head.approach)];
+        head.shape.setFillColor(state == GREEN ? sf::Color::Green :
+                                state == YELLOW ? sf::Color::Yellow : sf::Color::Red);
+        window.draw(head.shape);
+    });
+    drawn += world.each<Vehicle>([&](Entity, Vehicle &v) {
+        window.draw(v.sprite);
+    });
+
+    // Tow trucks belong to the dispatcher
+    static sf::Sprite towSprite(towTruckTexture);
+    towSprite.setScale(0.05f, 0.05f);
+    for (const auto &unit : dispatcher.getTowUnits()) {
+        towSprite.setPosition(unit.x, unit.y);
+        window.draw(towSprite);
+        drawn++;
+    }
+    return drawn;
 }
 
 // Visualization Function
-void visualizeTraffic(sf::RenderWindow &window, sf::Sprite &roadSprite, sf::Font &font, sf::Text &analyticsText) {
+void visualizeTraffic(sf::RenderWindow &window, sf::Sprite &roadSprite, sf::Text &analyticsText) {
     window.clear();
     window.draw(roadSprite);
 
-    // Draw Traffic Lights
-    for (const auto &entry : trafficLights) {
-        window.draw(entry.second.lightShape);
-    }
+    // One SPaT snapshot for the whole frame: lights, stop lines and red-light checks
+    std::shared_ptr<const SpatMessage> spat = spatBus.current();
 
-    // Move and Draw Vehicles
-    // Acquire ACTIVE_VEHICLES_SEM to access activeVehicles
+    // The simulation step runs from here to the flush; its transient data lives in the arena
+    stepArena.beginStep();
+
+    // Every frame is one stepSeconds step of simulated time
+    const float dt = static_cast<float>(stepSeconds);
+    dispatcher.update(dt);
+
+    // Span of this step on the simulation clock, used to timestamp stop-line crossings
+    double stepWall = simClockSeconds();
+    double stepStartWall = stepWall - stepSeconds;
+    std::vector<std::string> clearedVehicles = dispatcher.takeClearedVehicles();
+
+    // Acquire ACTIVE_VEHICLES_SEM to access the vehicles on the road
     if (!acquireResource(TRAFFIC_LIGHT_CONTROLLER, ACTIVE_VEHICLES_SEM)) {
         safePrint("[Banker] visualizeTraffic: Waiting for ACTIVE_VEHICLES_SEM resource.");
+        stepArena.endStep();
         return;
     }
 
-    for (auto &v : activeVehicles) {
-        if (v.outOfOrder || v.isTowed)
-            continue; // Skip out-of-order or towed vehicles
-
-        // Update vehicle position based on speed vector
-        v.sprite.move(v.speedVector.x * v.currentSpeed * 0.01f, v.speedVector.y * v.currentSpeed * 0.01f);
-
-        // Check if vehicle has exited the window bounds
-        if (v.sprite.getPosition().x < -50.f || v.sprite.getPosition().x > 850.f ||
-            v.sprite.getPosition().y < -50.f || v.sprite.getPosition().y > 650.f) {
-            // Remove vehicle from activeVehicles
-            safePrint("[visualizeTraffic] Vehicle " + v.numberPlate + " has exited the simulation.");
-            // Find and remove vehicle from laneQueues if necessary
-            for (auto &laneEntry : laneQueues) {
-                auto &laneQueue = laneEntry.second.vehicles;
-                laneQueue.erase(std::remove_if(laneQueue.begin(), laneQueue.end(),
-                    [&](const Vehicle &laneV) { return laneV.numberPlate == v.numberPlate; }),
-                    laneQueue.end());
-            }
-            v.isTowed = true; // Mark for removal
-            continue;
+    // Broken vehicles the tow trucks have hauled away leave the road
+    world.each<Breakdown, Vehicle>([&](Entity e, Breakdown &, Vehicle &v) {
+        if (std::find(clearedVehicles.begin(), clearedVehicles.end(), v.numberPlate) != clearedVehicles.end()) {
+            safePrintf("[Dispatch] Vehicle %s has been towed from lane %s.", v.numberPlate.c_str(), v.laneName.c_str());
+            removeVehicle(e);
         }
+    });
 
-        window.draw(v.sprite);
+    // Vehicle fronts per lane after this step, furthest first, for the loop detectors
+    LaneFronts laneFronts(&stepArena);
+    systems.run("movement", [&] { return movementSystem(*spat, dt, laneFronts); });
+    systems.run("violation", [&] { return violationSystem(*spat, stepStartWall, stepWall); });
+    systems.run("exit", [&] { return exitSystem(stepWall); });
+    systems.run("collision", collisionSystem);
+
+    // Loop detectors. Lanes come out of the pass in order apart from this step's lane changes.
+    for (auto &entry : laneFronts) {
+        std::sort(entry.second.begin(), entry.second.end(), std::greater<float>());
     }
+    loopDetectors.observe(laneFronts, stepWall);
 
-    // Remove towed vehicles from activeVehicles
-    activeVehicles.erase(
-        std::remove_if(activeVehicles.begin(), activeVehicles.end(),
-                       [](const Vehicle &v) { return v.isTowed; }),
-        activeVehicles.end());
+    // Entry reads of vehicles that never reached the exit camera expire here
+    sectionControl.evict(stepWall);
+
+    // Drop the vehicles that left the road this step
+    world.flush(parallelStep);
+    stepArena.endStep();
+
+    systems.run("render", [&] { return renderSystem(window, *spat); });
 
     // Release ACTIVE_VEHICLES_SEM
     releaseResource(TRAFFIC_LIGHT_CONTROLLER, ACTIVE_VEHICLES_SEM);
 
-    // Update Analytics
-    analyticsText.setString(
-        "Active Vehicles: " + std::to_string(activeVehicles.size()) + "\n" +
-        "Total Challans Issued: " + std::to_string(totalChallansIssued) + "\n" +
-        "Total Challans Paid: " + std::to_string(totalChallansPaid) + "\n" +
-        "Vehicles Out of Order: " + std::to_string(totalVehiclesOutOfOrder)
-    );
+    // Latest loop sample per detector, drained every frame so the feed never fills. The
+    // overlay text is only rebuilt every OVERLAY_REFRESH_SECONDS and set when it changed.
+    static std::vector<DetectorSample> latestSamples;
+    if (latestSamples.empty()) {
+        for (size_t i = 0; i < loopDetectors.size(); ++i) {
+            latestSamples.push_back({static_cast<int>(i), 0.0, 0.f, 0, 0.f});
+        }
+    }
+    DetectorSample sample;
+    while (analyticsDetectorFeed->pop(sample)) {
+        latestSamples[sample.detector] = sample;
+    }
+    static std::string analytics;
+    static std::chrono::steady_clock::time_point analyticsBuiltAt;
+    auto frameAt = std::chrono::steady_clock::now();
+    if (analytics.empty() ||
+        std::chrono::duration<double>(frameAt - analyticsBuiltAt).count() >= OVERLAY_REFRESH_SECONDS) {
+        analyticsBuiltAt = frameAt;
+
+        // Update Analytics
+        float minutes = static_cast<float>(simClockSeconds() - throughputSince) / 60.f;
+        float throughputPerMinute = minutes > 0.f ? vehiclesDischarged / minutes : 0.f;
+        SupervisorStats supervisorStats = supervisor.getStats();
+        DispatchStats dispatchStats = dispatcher.getStats();
+        SectionControlStats sectionStats = sectionControl.getStats();
+        double nowWall = simClockSeconds();
+
+        // Network-wide trips in hybrid mode, including those currently in the intersection
+        std::string hybridNetwork;
+        if (hybridMode) {
+            MesoStats mesoStats = mesoEngine.getStats();
+            hybridNetwork = "Meso Network: " + std::to_string(mesoStats.tripsCompleted) + " trips done, " +
+                            std::to_string(mesoStats.tripsHandedOff) + " here (mean travel time " +
+                            std::to_string(static_cast<int>(mesoStats.meanTravelTime)) + " s)\n";
+        }
+        EventSchedulerStats schedulerStats = scheduler.getStats();
+        StepArenaStats arenaStats = stepArena.getStats();
+        BankerStats bankerStats = banker.getStats();
+        std::string servedState = spat->state[spat->phase == 0 ? SPAT_NORTH : SPAT_EAST] == GREEN ? "GREEN" : "YELLOW";
+
+        std::map<std::string, float> approachOccupancy;
+        std::map<std::string, int> approachLoops;
+        for (const auto &latest : latestSamples) {
+            std::string approach = laneApproach(loopDetectors.getLane(latest.detector));
+            approachOccupancy[approach] += latest.occupancy;
+            approachLoops[approach]++;
+        }
+        std::string loopOccupancy;
+        for (const auto &entry : approachOccupancy) {
+            loopOccupancy += " " + entry.first.substr(0, 1) + " " +
+                             std::to_string(static_cast<int>(100.f * entry.second / approachLoops[entry.first])) + "%";
+        }
+        std::string systemTimes;
+        for (const auto &stat : systems.getStats()) {
+            systemTimes += " " + stat.name + " " + std::to_string(static_cast<int>(stat.lastMs * 1000.0)) + " us";
+        }
+        std::string overlay =
+            "Active Vehicles: " + std::to_string(world.pool<Vehicle>().size()) + "\n" +
+            "Total Challans Issued: " + std::to_string(totalChallansIssued) + "\n" +
+            "Total Challans Paid: " + std::to_string(totalChallansPaid) + "\n" +
+            "Speeding Violations: " + std::to_string(totalSpeedingViolations) + "\n" +
+            "Red-Light Violations: " + std::to_string(totalRedLightViolations) + "\n" +
+            "Wrong-Lane Violations: " + std::to_string(totalWrongLaneViolations) + "\n" +
+            "Average-Speed Violations: " + std::to_string(totalAverageSpeedViolations) +
+            " (join state " + std::to_string(sectionStats.joinState) +
+            ", peak " + std::to_string(sectionStats.peakJoinState) + ")\n" +
+            "Vehicles Out of Order: " + std::to_string(totalVehiclesOutOfOrder) + "\n" +
+            "Incidents Active: " + std::to_string(dispatchStats.incidentsActive) +
+            " Cleared: " + std::to_string(dispatchStats.incidentsCleared) +
+            " (avg " + std::to_string(dispatchStats.avgClearanceSec) + " s)\n" +
+            "Spillback Lanes Updated: " + std::to_string(laneGraph.getLastVisited()) + "\n" +
+            "Loop Occupancy:" + loopOccupancy + "\n" +
+            "Signal: " + (spat->phase == 0 ? "North/South " : "East/West ") + servedState +
+            ", change in " + std::to_string(static_cast<int>(spatMinTimeToChange(*spat, nowWall))) + "-" +
+            std::to_string(static_cast<int>(spatMaxTimeToChange(*spat, nowWall))) + " s\n" +
+            "Trips Completed: " + std::to_string(tripsCompleted) + " (mean travel time " +
+            std::to_string(static_cast<int>(tripsCompleted > 0 ? totalTravelTime / tripsCompleted : 0.0)) + " s)\n" +
+            "Approach Throughput: " + std::to_string(static_cast<int>(throughputPerMinute)) + " veh/min" +
+            (laneChangesEnabled ? " (lane changes on)" : " (lane changes off)") + "\n" +
+            hybridNetwork +
+            "Event List: " + std::to_string(schedulerStats.pending) + " pending, " +
+            std::to_string(schedulerStats.eventsProcessed) + " processed, idle " +
+            std::to_string(static_cast<int>(scheduler.now() > 0.0 ? 100.0 * schedulerStats.idleSeconds / scheduler.now() : 0.0)) +
+            "%\n" +
+            "Systems:" + systemTimes + "\n" +
+            "Step Memory: " +
+            (HEAP_ALLOCATIONS_COUNTED ? std::to_string(arenaStats.lastStepHeapAllocations) + " heap allocations (peak " +
+                                            std::to_string(arenaStats.peakStepHeapAllocations) + ", first step " +
+                                            std::to_string(arenaStats.firstStepHeapAllocations) + "), "
+                                      : std::string()) +
+            "arena " +
+            std::to_string(arenaStats.lastStepBytes / 1024) + "/" + std::to_string(arenaStats.capacity / 1024) + " KB\n" +
+            "Banker Checks: " + std::to_string(bankerStats.safetyChecks) + ", " +
+            std::to_string(static_cast<int>(bankerStats.safetyChecks > 0 ? 100.0 * bankerStats.cacheHits / bankerStats.safetyChecks : 0.0)) +
+            "% from the cached sequence (" + std::to_string(static_cast<int>(bankerStats.meanCachedCheckNs)) + " ns, full " +
+            std::to_string(static_cast<int>(bankerStats.meanFullCheckNs)) + " ns)\n" +
+            "Worker Restarts: " + std::to_string(supervisorStats.totalRestarts) +
+            " (last " + std::to_string(supervisorStats.lastRestartLatencyMs) + " ms), " +
+            std::to_string(supervisorStats.failedSpawns) + " failed spawns, " +
+            std::to_string(supervisorStats.workersGivenUp) + " given up";
+        if (overlay != analytics) {
+            analytics.swap(overlay);
+            analyticsText.setString(analytics);
+        }
+    }
 
     window.draw(analyticsText);
     window.display();
 
-    // Handle collisions and cleanup after drawing
-    handleCollisionsAndCleanup();
+    if (!firstFrameShown) {
+        firstFrameShown = true;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+        std::cout << "[Startup] First frame " << ms << " ms after launch; assets decoded in " << assetDecodeMs
+                  << " ms on worker threads (" << assetSerialDecodeMs << " ms one by one), uploaded in "
+                  << assetUploadMs << " ms" << std::endl;
+    }
 }
 
 // Cleanup and Exit Function
-void performCleanup(pid_t pid1, pid_t pid2, pid_t pid3, pid_t pid4) {
+void performCleanup() {
     running = false;
 
-    // Terminate child processes
-    if (pid1 > 0) kill(pid1, SIGTERM);
-    if (pid2 > 0) kill(pid2, SIGTERM);
-    if (pid3 > 0) kill(pid3, SIGTERM);
-    if (pid4 > 0) kill(pid4, SIGTERM);
-
-    // Wait for child processes to terminate
-    if (pid1 > 0) waitpid(pid1, NULL, 0);
-    if (pid2 > 0) waitpid(pid2, NULL, 0);
-    if (pid3 > 0) waitpid(pid3, NULL, 0);
-    if (pid4 > 0) waitpid(pid4, NULL, 0);
+    // Terminate and reap all supervised child processes
+    supervisor.stopAll();
 
     // Close and unlink semaphores
     if (laneSem != SEM_FAILED) {
         sem_close(laneSem);
-        sem_unlink("/laneSem");
+        sem_unlink(SEM_LANE);
     }
     if (activeVehiclesSem != SEM_FAILED) {
         sem_close(activeVehiclesSem);
-        sem_unlink("/activeVehiclesSem");
+        sem_unlink(SEM_ACTIVE_VEHICLES);
     }
 
     // Close and unlink message queues
-    if (mqSmartToChallan != (mqd_t)-1) {
-        mq_close(mqSmartToChallan);
-        mq_unlink(MQ_SMART_TO_CHALLAN);
+    for (int shard = 0; shard < numChallanWorkers; ++shard) {
+        if (mqSmartToChallanShards[shard] != (mqd_t)-1) {
+            mq_close(mqSmartToChallanShards[shard]);
+            mq_unlink(challanShardQueueName(shard).c_str());
+        }
     }
 
     if (mqStripeToChallan != (mqd_t)-1) {
@@ -1004,6 +1805,11 @@ void performCleanup(pid_t pid1, pid_t pid2, pid_t pid3, pid_t pid4) {
         mq_unlink(MQ_STRIPE_TO_CHALLAN);
     }
 
+    if (mqStripeToSmart != (mqd_t)-1) {
+        mq_close(mqStripeToSmart);
+        mq_unlink(MQ_STRIPE_TO_SMART);
+    }
+
     if (mqChallanToSmart != (mqd_t)-1) {
         mq_close(mqChallanToSmart);
         mq_unlink(MQ_CHALLAN_TO_SMART);
@@ -1019,29 +1825,353 @@ void performCleanup(pid_t pid1, pid_t pid2, pid_t pid3, pid_t pid4) {
 }
 
 // Signal Handler
-void cleanupAndExit(int signum) {
+// The supervisor reads SIGINT/SIGTERM from its signalfd and passes them here. This
+// only clears `running`; the event loop on the main thread sees it and returns, and
+// main() then joins its threads and runs performCleanup() on the main thread.
+void requestShutdown(int signum) {
     std::cout << "\nInterrupt signal (" << signum << ") received.\n";
-    // Assuming pid1, pid2, pid3, pid4 are accessible
-    performCleanup(-1, -1, -1, -1); // Placeholder; adjust as needed
+    running = false;
+}
+
+// Meso grid laid out like the micro intersection
+MesoGridParams mesoGridParams() {
+    MesoGridParams params;
+    params.linkLength = MESO_LINK_LENGTH;
+    params.freeSpeed = 60.f * SPEED_TO_PIXELS_PER_SEC;
+    params.vehicleSpacing = VEHICLE_SPACING;
+    params.laneHeadway = VEHICLE_SPACING / params.freeSpeed;
+    params.green = MESO_GREEN_SECONDS;
+    params.amber = YELLOW_SECONDS;
+    return params;
+}
+
+// Headless mesoscopic run over a rows x cols grid of intersections laid out like the
+// micro one: same vehicle spacing, light-vehicle speed limit and amber time
+int runMesoscopic(int rows, int cols, long long trips) {
+    MesoEngine engine(std::random_device{}());
+    int links = engine.buildGrid(rows, cols, mesoGridParams());
+    std::cout << "[Meso] " << rows << "x" << cols << " grid, " << links << " links, " << trips << " trips" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    MesoStats stats = engine.run(trips);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[Meso] Trips completed: " << stats.tripsCompleted << "/" << stats.tripsStarted << "\n"
+              << "[Meso] Mean travel time: " << stats.meanTravelTime << " s (delay " << stats.meanDelay
+              << " s, max " << stats.maxTravelTime << " s)\n"
+              << "[Meso] Throughput: " << stats.throughputPerMinute << " veh/min\n"
+              << "[Meso] Longest queue: " << stats.maxQueue << " vehicles\n"
+              << "[Meso] Events: " << stats.eventsProcessed << ", simulated " << stats.simulatedSeconds
+              << " s in " << wallSeconds << " s wall (" << (wallSeconds > 0.0 ? stats.simulatedSeconds / wallSeconds : 0.0)
+              << "x real time)" << std::endl;
+    if (stats.gridlocked) {
+        std::cerr << "[Meso] Stopped: network gridlocked." << std::endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
+
+// Headless timing of the per-step vehicle pipeline (integrate, classify exits,
+// compact) over a synthetic fleet spread along the lanes, serial against parallel
+int runStepBenchmark(size_t vehicleCount, int steps) {
+    std::mt19937 gen(std::random_device{}());
+    std::uniform_real_distribution<float> speedDist(20.f, 100.f);
+    std::uniform_real_distribution<float> progressDist(0.f, 800.f);
+    std::vector<std::string> lanes;
+    for (const auto &entry : lanePositions) {
+        lanes.push_back(entry.first);
+    }
+    auto spawn = [&](size_t serial, bool anywhere) {
+        Vehicle v;
+        v.type = LIGHT;
+        v.laneName = lanes[serial % lanes.size()];
+        v.numberPlate = "BENCH-" + std::to_string(serial);
+        v.currentSpeed = v.maxSpeed = speedDist(gen);
+        v.speedVector = laneDirections[v.laneName];
+        v.sprite.setPosition(lanePositions[v.laneName] + v.speedVector * (anywhere ? progressDist(gen) : 0.f));
+        return v;
+    };
+
+    std::vector<Vehicle> fleet;
+    fleet.reserve(vehicleCount);
+    for (size_t i = 0; i < vehicleCount; ++i) {
+        fleet.push_back(spawn(i, true));
+    }
+    std::cout << "[StepBench] " << vehicleCount << " vehicles, " << steps << " steps, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    double serialSeconds = 0.0;
+    for (bool parallel : {false, true}) {
+        Registry road;
+        auto enter = [&](const Vehicle &v) {
+            Entity e = road.create();
+            road.add<Vehicle>(e, v);
+            road.add<Driving>(e, Driving());
+        };
+        for (const auto &v : fleet) {
+            enter(v);
+        }
+        ComponentPool<Driving> &driving = road.pool<Driving>();
+        ComponentPool<Vehicle> &vehicles = road.pool<Vehicle>();
+        std::vector<char> exited;
+        size_t spawned = vehicleCount;
+        double integrateSeconds = 0.0, classifySeconds = 0.0, compactSeconds = 0.0;
+        for (int s = 0; s < steps; ++s) {
+            road.each<Driving, Vehicle>([&](Entity, Driving &d, Vehicle &v) {
+                d.step = v.currentSpeed * SPEED_TO_PIXELS_PER_SEC * static_cast<float>(stepSeconds);
+            });
+
+            auto t0 = std::chrono::steady_clock::now();
+            integrateVehicles(road, parallel);
+            auto t1 = std::chrono::steady_clock::now();
+            exited.assign(driving.size(), 0);
+            parallelForChunks(driving.size(), parallel, [&](size_t begin, size_t end) {
+                for (size_t pos = begin; pos < end; ++pos) {
+                    exited[pos] = outsideWindow(vehicles.get(driving.entityAt(pos)).sprite.getPosition());
+                }
+            });
+            for (size_t pos = 0; pos < exited.size(); ++pos) {
+                if (exited[pos]) road.destroy(driving.entityAt(pos));
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            road.flush(parallel);
+            auto t3 = std::chrono::steady_clock::now();
+            integrateSeconds += std::chrono::duration<double>(t1 - t0).count();
+            classifySeconds += std::chrono::duration<double>(t2 - t1).count();
+            compactSeconds += std::chrono::duration<double>(t3 - t2).count();
+
+            // Keep the fleet size steady: exited vehicles come back in at the lane entries
+            while (road.size() < vehicleCount) {
+                enter(spawn(spawned++, false));
+            }
+        }
+
+        double total = integrateSeconds + classifySeconds + compactSeconds;
+        if (!parallel) serialSeconds = total;
+        std::cout << "[StepBench] " << (parallel ? "parallel" : "serial  ") << ": "
+                  << total * 1000.0 / steps << " ms/step (integrate " << integrateSeconds * 1000.0 / steps
+                  << ", classify " << classifySeconds * 1000.0 / steps << ", compact "
+                  << compactSeconds * 1000.0 / steps << "), " << (spawned - vehicleCount) << " exits";
+        if (parallel && total > 0.0) std::cout << ", speedup " << serialSeconds / total << "x";
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+// Headless timing of acquireResource/releaseResource pairs, split into the
+// Banker's bookkeeping and the semaphore operations, with heap allocations counted
+int runBankerBenchmark(long long iterations) {
+    initializeBankers();
+    sem_t benchLaneSem, benchActiveVehiclesSem;
+    if (sem_init(&benchLaneSem, 0, 1) == -1 || sem_init(&benchActiveVehiclesSem, 0, 1) == -1) {
+        perror("sem_init");
+        return EXIT_FAILURE;
+    }
+    laneSem = &benchLaneSem;
+    activeVehiclesSem = &benchActiveVehiclesSem;
+    std::cout << "[BankerBench] " << iterations << " acquire/release pairs per case" << std::endl;
+
+    auto measure = [&](const char *name, auto pair) {
+        unsigned long long heapBefore = threadHeapAllocations();
+        long long refused = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < iterations; ++i) {
+            if (!pair(static_cast<int>(i % NUM_PROCESSES), static_cast<ResourceType>(i % NUM_RESOURCE_TYPES))) {
+                refused++;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        unsigned long long heap = threadHeapAllocations() - heapBefore;
+        std::cout << "[BankerBench] " << name << ": " << seconds * 1e9 / iterations << " ns/pair";
+        if (HEAP_ALLOCATIONS_COUNTED) {
+            std::cout << ", " << static_cast<double>(heap) / iterations << " heap allocations/pair";
+        }
+        if (refused > 0) std::cout << ", " << refused << " refused";
+        std::cout << std::endl;
+    };
+
+    measure("banker only   ", [](int process, ResourceType res) {
+        ResourceVector units = singleUnit(res);
+        if (!banker.requestResources(process, units)) return false;
+        banker.releaseResources(process, units);
+        return true;
+    });
+    measure("semaphore only", [](int, ResourceType res) {
+        sem_t *sem = res == LANE_SEM ? laneSem : activeVehiclesSem;
+        return sem_wait(sem) == 0 && sem_post(sem) == 0;
+    });
+    measure("acquire/release", [](int process, ResourceType res) {
+        if (!acquireResource(process, res)) return false;
+        releaseResource(process, res);
+        return true;
+    });
+
+    // Vehicles coming and going: a window of short-lived processes, each
+    // registered, served once and unregistered, next to the long-lived ones
+    static const int CHURN_WINDOW = 64;
+    std::vector<int> transient(CHURN_WINDOW); // ring, oldest first at `oldest`
+    size_t oldest = 0;
+    ResourceVector vehicleDemand = singleUnit(ACTIVE_VEHICLES_SEM);
+    for (int &process : transient) {
+        process = banker.registerProcess(vehicleDemand);
+    }
+    measure("process churn ", [&](int, ResourceType) {
+        banker.unregisterProcess(transient[oldest]);
+        int process = banker.registerProcess(vehicleDemand);
+        transient[oldest] = process;
+        oldest = (oldest + 1) % transient.size();
+        if (!banker.requestResources(process, vehicleDemand)) return false;
+        banker.releaseResources(process, vehicleDemand);
+        return true;
+    });
+    for (int process : transient) {
+        banker.unregisterProcess(process);
+    }
+    measure("after churn   ", [](int process, ResourceType res) {
+        ResourceVector units = singleUnit(res);
+        if (!banker.requestResources(process, units)) return false;
+        banker.releaseResources(process, units);
+        return true;
+    });
+    std::cout << "[BankerBench] " << banker.liveProcesses() << " live processes after churn" << std::endl;
+    BankerStats bankerStats = banker.getStats();
+    std::cout << "[BankerBench] " << bankerStats.safetyChecks << " safety checks, " << bankerStats.cacheHits
+              << " from the cached sequence (mean " << bankerStats.meanCachedCheckNs << " ns, full "
+              << bankerStats.meanFullCheckNs << " ns)" << std::endl;
+
+    // Intersections admitting vehicles at once, one thread each: all behind one
+    // Banker, each with its own shard, and each also asking the next
+    // intersection for a unit through ordered cross-shard requests
+    const int intersections = std::max(4, static_cast<int>(std::thread::hardware_concurrency()));
+    auto concurrent = [&](const char *name, int shardCount, bool cross) {
+        BankerShards shards(shardCount, NUM_RESOURCE_TYPES, intersections);
+        for (int sh = 0; sh < shardCount; ++sh) {
+            shards.shard(sh).setTotalResources(std::vector<int>(NUM_RESOURCE_TYPES, intersections));
+            for (int p = 0; p < intersections; ++p) {
+                shards.shard(sh).setMaximum(p, std::vector<int>(NUM_RESOURCE_TYPES, 1));
+            }
+        }
+        const long long perThread = iterations / intersections + 1;
+        std::atomic<long long> refused{0};
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < intersections; ++t) {
+            threads.emplace_back([&, t] {
+                int home = t % shardCount, next = (t + 1) % shardCount;
+                ShardRequest requests[2] = {{home, t, singleUnit(LANE_SEM)}, {next, t, singleUnit(LANE_SEM)}};
+                int count = 1;
+                if (cross && next != home) {
+                    requests[0].shard = std::min(home, next);
+                    requests[1].shard = std::max(home, next);
+                    count = 2;
+                }
+                for (long long i = 0; i < perThread; ++i) {
+                    if (shards.requestOrdered(requests, count)) {
+                        shards.releaseOrdered(requests, count);
+                    } else {
+                        refused++;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        BankerShardStats stats = shards.getStats();
+        std::cout << "[BankerBench] " << name << ": " << perThread * intersections / seconds / 1e6
+                  << " M requests/s over " << intersections << " threads, " << refused.load() << " refused, "
+                  << stats.backouts << " backed out" << std::endl;
+    };
+    concurrent("one banker    ", 1, false);
+    concurrent("sharded       ", intersections, false);
+    concurrent("sharded, cross", intersections, true);
+
+    laneSem = SEM_FAILED;
+    activeVehiclesSem = SEM_FAILED;
+    sem_destroy(&benchLaneSem);
+    sem_destroy(&benchActiveVehiclesSem);
+    return 0;
 }
 
 // Main Function
-int main() {
-    // Register signal handler
-    signal(SIGINT, cleanupAndExit);
+int main(int argc, char *argv[]) {
+    startupBegin = std::chrono::steady_clock::now();
+
+    // Options that combine with any mode
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--fast") == 0) {
+            fastMode = true;
+        } else if (std::strcmp(argv[i], "--parallel") == 0) {
+            parallelStep = true;
+        } else if (std::strcmp(argv[i], "--spawn-interval") == 0 && i + 1 < argc) {
+            spawnInterval = std::max(0.01, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--dt") == 0 && i + 1 < argc) {
+            stepSeconds = std::min(MAX_STEP_SECONDS, std::max(FRAME_SECONDS, std::atof(argv[++i])));
+        }
+    }
+
+    // Mesoscopic mode runs headless, without the IPC and rendering set up below
+    if (argc >= 5 && std::strcmp(argv[1], "--meso") == 0) {
+        return runMesoscopic(std::atoi(argv[2]), std::atoi(argv[3]), std::atoll(argv[4]));
+    }
+
+    // Benchmark of the vehicle step kernels, also headless
+    if (argc >= 4 && std::strcmp(argv[1], "--step-bench") == 0) {
+        return runStepBenchmark(static_cast<size_t>(std::max(1LL, std::atoll(argv[2]))), std::max(1, std::atoi(argv[3])));
+    }
+
+    // Benchmark of the resource fast path, also headless
+    if (argc >= 3 && std::strcmp(argv[1], "--banker-bench") == 0) {
+        return runBankerBenchmark(std::max(1LL, std::atoll(argv[2])));
+    }
+
+    // Deadlock-handling strategies compared on one workload, also headless
+    if (argc >= 4 && std::strcmp(argv[1], "--deadlock-bench") == 0) {
+        return runDeadlockBenchmark(std::max(2, std::atoi(argv[2])), std::max(1LL, std::atoll(argv[3])));
+    }
+
+    // Hybrid mode: this intersection is cell (ROW, COL) of a ROWS x COLS meso grid
+    if (argc >= 6 && std::strcmp(argv[1], "--hybrid") == 0) {
+        int rows = std::atoi(argv[2]), cols = std::atoi(argv[3]);
+        hybridRow = std::atoi(argv[4]);
+        hybridCol = std::atoi(argv[5]);
+        if (rows < 1 || cols < 1 || hybridRow < 0 || hybridRow >= rows || hybridCol < 0 || hybridCol >= cols) {
+            std::cerr << "Hybrid cell (" << hybridRow << ", " << hybridCol << ") is outside the "
+                      << rows << "x" << cols << " grid." << std::endl;
+            return EXIT_FAILURE;
+        }
+        mesoEngine.buildGrid(rows, cols, mesoGridParams());
+        for (const auto &entry : approachDirection) {
+            int link = mesoEngine.gridLink(hybridRow, hybridCol, entry.second);
+            mesoEngine.setHandoffLink(link, 2 * LaneQueue().maxCapacity);
+            handoffApproach[link] = entry.first;
+        }
+        hybridMode = true;
+    }
+
+    // Decode the textures and the font on worker threads while IPC, semaphores
+    // and the child processes are set up; they are uploaded before the window opens
+    AssetLoader assets;
+    assets.loadTexture("road.jpg", roadTexture);
+    assets.loadTexture("car1.png", carTexture1);
+    assets.loadTexture("car2.png", carTexture2);
+    assets.loadTexture("vehicle.png", towTruckTexture);
+    sf::Font font;
+    assets.loadFont("DejaVuSans.ttf", font); // Ensure DejaVuSans.ttf is present
 
     // Initialize Banker's Algorithm
     initializeBankers();
 
     // Create and initialize semaphores
-    laneSem = sem_open("/laneSem", O_CREAT | O_EXCL, 0644, 1);
-    activeVehiclesSem = sem_open("/activeVehiclesSem", O_CREAT | O_EXCL, 0644, 1);
+    laneSem = sem_open(SEM_LANE, O_CREAT | O_EXCL, 0644, 1);
+    activeVehiclesSem = sem_open(SEM_ACTIVE_VEHICLES, O_CREAT | O_EXCL, 0644, 1);
     if (laneSem == SEM_FAILED || activeVehiclesSem == SEM_FAILED) {
         std::cerr << "Failed to create semaphores: " << strerror(errno) << std::endl;
         if (laneSem != SEM_FAILED) sem_close(laneSem);
         if (activeVehiclesSem != SEM_FAILED) sem_close(activeVehiclesSem);
-        sem_unlink("/laneSem");
-        sem_unlink("/activeVehiclesSem");
+        sem_unlink(SEM_LANE);
+        sem_unlink(SEM_ACTIVE_VEHICLES);
         return EXIT_FAILURE;
     }
 
@@ -1051,9 +2181,56 @@ int main() {
         laneQueues[lane] = LaneQueue();
     }
 
+    // The simulation clock starts here; violations and SPaT messages are stamped from it
+    simEpoch = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    throughputSince = simEpoch;
+
     // Initialize Traffic Lights
     initializeTrafficLights();
 
+    // Entity tables and the violation backlog get their room now, not mid-step
+    world.pool<Vehicle>();
+    world.pool<Driving>();
+    world.pool<Breakdown>();
+    world.reserve(STEP_RESERVED_VEHICLES);
+    pendingViolations.reserve(MAX_PENDING_VIOLATIONS + STEP_RESERVED_VEHICLES);
+
+    // Tow trucks are routed through the lane entries and wait at depots near two corners
+    for (const auto &lane : lanes) {
+        dispatcher.setLaneEntry(lane, lanePositions[lane].x, lanePositions[lane].y);
+    }
+    dispatcher.addTowUnit("TOW-1", 40.f, 40.f, 120.f);
+    dispatcher.addTowUnit("TOW-2", 760.f, 560.f, 120.f);
+
+    // Stop lines span the lane, 10px to either side of its centre. Every lane starts
+    // with an empty tail, so the step only ever updates existing entries.
+    for (const auto &lane : lanes) {
+        laneTailProgress[lane] = std::numeric_limits<float>::max();
+        laneStopLines[lane] = makeStopLine(lanePositions[lane].x, lanePositions[lane].y,
+                                           laneDirections[lane].x, laneDirections[lane].y,
+                                           laneStopDistances[lane], 10.f);
+    }
+
+    // Section control: one camera pair per approach
+    for (const auto &entry : sectionExitCameras) {
+        sectionControl.addSection(entry.first, entry.second - SECTION_ENTRY_CAMERA);
+    }
+
+    // Loop detectors: advance and stop-bar loop on every lane, then one feed per consumer
+    for (const auto &lane : lanes) {
+        loopDetectors.addDetector(lane, ADVANCE_DETECTOR_DISTANCE, DETECTOR_LENGTH);
+        loopDetectors.addDetector(lane, laneStopDistances[lane] - STOP_BAR_DETECTOR_SETBACK, DETECTOR_LENGTH);
+    }
+    controllerDetectorFeed = loopDetectors.subscribe(DETECTOR_RING_CAPACITY);
+    analyticsDetectorFeed = loopDetectors.subscribe(DETECTOR_RING_CAPACITY);
+
+    // Spillback graph: queue -> lane segment for every lane
+    for (const auto &lane : lanes) {
+        laneGraph.addLane(laneQueueNode(lane), LaneQueue().maxCapacity);
+        laneGraph.addLane(lane, LANE_SEGMENT_CAPACITY);
+        laneGraph.connect(laneQueueNode(lane), lane);
+    }
+
     // Create message queues
     struct mq_attr mqAttr;
     mqAttr.mq_flags = O_NONBLOCK;
@@ -1061,92 +2238,77 @@ int main() {
     mqAttr.mq_msgsize = MQ_MAX_SIZE;
     mqAttr.mq_curmsgs = 0;
 
+    // One violation queue per challan worker
+    numChallanWorkers = static_cast<int>(std::thread::hardware_concurrency());
+    if (numChallanWorkers < 1) numChallanWorkers = 1;
+    if (numChallanWorkers > MAX_CHALLAN_WORKERS) numChallanWorkers = MAX_CHALLAN_WORKERS;
+    for (int shard = 0; shard < MAX_CHALLAN_WORKERS; ++shard) {
+        mqSmartToChallanShards[shard] = (mqd_t)-1;
+    }
+
     // Unlink in case they already exist
-    mq_unlink(MQ_SMART_TO_CHALLAN);
+    for (int shard = 0; shard < numChallanWorkers; ++shard) {
+        mq_unlink(challanShardQueueName(shard).c_str());
+    }
     mq_unlink(MQ_STRIPE_TO_CHALLAN);
     mq_unlink(MQ_CHALLAN_TO_SMART);
+    mq_unlink(MQ_STRIPE_TO_SMART);
     mq_unlink(MQ_PORTAL_STATUS);
 
     // Open message queues
-    mqSmartToChallan = mq_open(MQ_SMART_TO_CHALLAN, O_CREAT | O_WRONLY, 0644, &mqAttr);
+    bool shardQueuesOpen = true;
+    for (int shard = 0; shard < numChallanWorkers; ++shard) {
+        mqSmartToChallanShards[shard] = mq_open(challanShardQueueName(shard).c_str(), O_CREAT | O_WRONLY | O_NONBLOCK, 0644, &mqAttr);
+        if (mqSmartToChallanShards[shard] == (mqd_t)-1) shardQueuesOpen = false;
+    }
     mqStripeToChallan = mq_open(MQ_STRIPE_TO_CHALLAN, O_CREAT | O_WRONLY, 0644, &mqAttr);
     mqChallanToSmart = mq_open(MQ_CHALLAN_TO_SMART, O_CREAT | O_RDONLY | O_NONBLOCK, 0644, &mqAttr);
+    mqStripeToSmart = mq_open(MQ_STRIPE_TO_SMART, O_CREAT | O_RDONLY | O_NONBLOCK, 0644, &mqAttr);
     // Portal Status message queue is opened as O_RDONLY | O_NONBLOCK in main
     // Not opened yet; will be opened in portalStatusListener
 
-    if (mqSmartToChallan == (mqd_t)-1 || mqStripeToChallan == (mqd_t)-1 || mqChallanToSmart == (mqd_t)-1) {
+    if (!shardQueuesOpen || mqStripeToChallan == (mqd_t)-1 || mqChallanToSmart == (mqd_t)-1 ||
+        mqStripeToSmart == (mqd_t)-1) {
         std::cerr << "Failed to create message queues: " << strerror(errno) << std::endl;
-        performCleanup(-1, -1, -1, -1);
+        performCleanup();
     }
 
-    // Load textures
-    if (!roadTexture.loadFromFile("road.jpg") ||
-        !carTexture1.loadFromFile("car1.png") ||
-        !carTexture2.loadFromFile("car2.png") ||
-        !towTruckTexture.loadFromFile("vehicle.png")) { // Changed to 'vehicle.png'
-        std::cerr << "Failed to load textures!" << std::endl;
-        performCleanup(-1, -1, -1, -1);
-    }
-
-    // Load font
-    sf::Font font;
-    if (!font.loadFromFile("DejaVuSans.ttf")) { // Ensure DejaVuSans.ttf is present
-        std::cerr << "Failed to load font 'DejaVuSans.ttf'!" << std::endl;
-        performCleanup(-1, -1, -1, -1);
-    }
-
-    sf::Text analyticsText;
-    analyticsText.setFont(font);
-    analyticsText.setCharacterSize(14);
-    analyticsText.setFillColor(sf::Color::White);
-    analyticsText.setPosition(10.f, 10.f);
-
-    // Fork child processes for ChallanGenerator, StripePayment, UserPortal
-    pid_t pidChallanGenerator = fork();
-    if (pidChallanGenerator == 0) {
-        // Child process: Challan Generator
-        challanGeneratorProcess();
-        exit(0);
-    }
-    else if (pidChallanGenerator < 0) {
-        std::cerr << "Failed to fork ChallanGenerator: " << strerror(errno) << std::endl;
-        performCleanup(-1, -1, -1, -1);
-    }
-
-    pid_t pidStripePayment = fork();
-    if (pidStripePayment == 0) {
-        // Child process: StripePayment
-        stripePaymentProcess();
-        exit(0);
-    }
-    else if (pidStripePayment < 0) {
-        std::cerr << "Failed to fork StripePayment: " << strerror(errno) << std::endl;
-        performCleanup(pidChallanGenerator, -1, -1, -1);
+    // Initialize and open the portal status message queue for reading; the listener waits on it.
+    // It must exist before the UserPortal is spawned, which opens it without O_CREAT
+    mqd_t mqPortalStatus = mq_open(MQ_PORTAL_STATUS, O_CREAT | O_RDONLY, 0644, &mqAttr);
+    mqPortalStatusHandle = mqPortalStatus;
+    if (mqPortalStatus == (mqd_t)-1) {
+        std::cerr << "Failed to create/open portal status message queue in main." << std::endl;
+        performCleanup();
     }
 
-    pid_t pidUserPortal = fork();
-    if (pidUserPortal == 0) {
-        // Child process: User Portal
-        userPortalProcess();
-        exit(0);
+    // Spawn the ChallanGenerator pool, StripePayment and UserPortal executables under the supervisor.
+    // Crashed children are spawned again and re-open their message queues by name.
+    // Starting the supervisor blocks SIGINT/SIGTERM/SIGCHLD, so it must happen
+    // before any simulation thread is created.
+    for (int shard = 0; shard < numChallanWorkers; ++shard) {
+        supervisor.addChild("ChallanGenerator " + std::to_string(shard),
+                            {siblingExecutable(CHALLAN_GENERATOR_EXECUTABLE), std::to_string(shard)});
     }
-    else if (pidUserPortal < 0) {
-        std::cerr << "Failed to fork UserPortal: " << strerror(errno) << std::endl;
-        performCleanup(pidChallanGenerator, pidStripePayment, -1, -1);
-    }
-
-    // Initialize and open the portal status message queue for reading
-    mqd_t mqPortalStatus = mq_open(MQ_PORTAL_STATUS, O_CREAT | O_RDONLY | O_NONBLOCK, 0644, &mqAttr);
-    if (mqPortalStatus == (mqd_t)-1) {
-        std::cerr << "Failed to create/open portal status message queue in main." << std::endl;
-        performCleanup(pidChallanGenerator, pidStripePayment, pidUserPortal, -1);
+    supervisor.addChild("StripePayment", {siblingExecutable(STRIPE_PAYMENT_EXECUTABLE)});
+    supervisor.addChild("UserPortal", {siblingExecutable(USER_PORTAL_EXECUTABLE)});
+    supervisor.setShutdownHandler(requestShutdown);
+    if (!supervisor.start()) {
+        std::cerr << "Failed to start child processes." << std::endl;
+        performCleanup();
     }
 
     // Start the portal status listener thread
     std::thread portalStatusListener([&]() {
-        char buffer[sizeof(PortalStatusMsg)];
+        char buffer[MQ_MAX_SIZE]; // mq_receive needs room for the queue's full message size
         while (running) {
-            ssize_t bytesRead = mq_receive(mqPortalStatus, buffer, sizeof(PortalStatusMsg), NULL);
+            // Wake up now and then so the thread notices shutdown
+            timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 500000000L;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            ssize_t bytesRead = mq_timedreceive(mqPortalStatus, buffer, sizeof(buffer), NULL, &deadline);
             if (bytesRead > 0) {
                 PortalStatusMsg* msg = reinterpret_cast<PortalStatusMsg*>(buffer);
                 std::string status(msg->status);
@@ -1160,107 +2322,58 @@ int main() {
                     std::cout << "[INFO] User Portal is now INACTIVE. Resuming main simulation output." << std::endl;
                 }
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
         }
     });
 
-    // Start simulation threads
-    pthread_t tLight, tSpawn, tSpeed, tOutOfOrder, tMockTime;
-
-    // Traffic Light Controller
-    {
-        int rc = pthread_create(&tLight, nullptr, [](void*)->void* {
-            trafficLightControllerThread();
-            return nullptr;
-        }, nullptr);
-        if (rc != 0) {
-            std::cerr << "Failed to create tLight thread: " << strerror(rc) << std::endl;
-            performCleanup(pidChallanGenerator, pidStripePayment, pidUserPortal, -1);
-        }
-    }
-
-    // Spawn Vehicles
-    {
-        sf::Texture* textures[3] = { &carTexture1, &carTexture2, &towTruckTexture };
-        int rc = pthread_create(&tSpawn, nullptr, [](void* arg)->void* {
-            sf::Texture** tex = reinterpret_cast<sf::Texture**>(arg);
-            spawnVehiclesThread(tex[0], tex[1], tex[2]);
-            return nullptr;
-        }, textures);
-        if (rc != 0) {
-            std::cerr << "Failed to create tSpawn thread: " << strerror(rc) << std::endl;
-            performCleanup(pidChallanGenerator, pidStripePayment, pidUserPortal, -1);
-        }
-    }
-
-    // Speed Manager
-    {
-        int rc = pthread_create(&tSpeed, nullptr, [](void*)->void* {
-            speedManagerThread();
-            return nullptr;
-        }, nullptr);
-        if (rc != 0) {
-            std::cerr << "Failed to create tSpeed thread: " << strerror(rc) << std::endl;
-            performCleanup(pidChallanGenerator, pidStripePayment, pidUserPortal, -1);
-        }
-    }
-
-    // Out-of-Order
+    // The SPaT broadcaster is the one simulation thread left; it sleeps until a message is published
+    pthread_t tSpat;
+    bool spatStarted = false;
+    // Both threads check `running` at least every half second; they are joined
+    // before the cleanup so nothing is torn down under them
+    auto stopThreads = [&]() {
+        running = false;
+        if (portalStatusListener.joinable()) portalStatusListener.join();
+        if (spatStarted) pthread_join(tSpat, nullptr);
+    };
     {
-        int rc = pthread_create(&tOutOfOrder, nullptr, [](void*)->void* {
-            outOfOrderThread();
+        int rc = pthread_create(&tSpat, nullptr, [](void*)->void* {
+            spatBroadcasterThread();
             return nullptr;
         }, nullptr);
         if (rc != 0) {
-            std::cerr << "Failed to create tOutOfOrder thread: " << strerror(rc) << std::endl;
-            performCleanup(pidChallanGenerator, pidStripePayment, pidUserPortal, -1);
+            std::cerr << "Failed to create tSpat thread: " << strerror(rc) << std::endl;
+            stopThreads();
+            performCleanup();
         }
+        spatStarted = true;
     }
 
-    // Mock Time
-    {
-        int rc = pthread_create(&tMockTime, nullptr, [](void*)->void* {
-            mockTimeThread();
-            return nullptr;
-        }, nullptr);
-        if (rc != 0) {
-            std::cerr << "Failed to create tMockTime thread: " << strerror(rc) << std::endl;
-            performCleanup(pidChallanGenerator, pidStripePayment, pidUserPortal, -1);
-        }
+    // Upload the decoded assets on this, the render thread
+    if (!assets.finish()) {
+        stopThreads();
+        performCleanup();
     }
+    assetDecodeMs = assets.getDecodeMs();
+    assetSerialDecodeMs = assets.getSerialDecodeMs();
+    assetUploadMs = assets.getUploadMs();
 
-    // Start a listener thread for challan updates (optional)
-    std::thread challanListenerThread([&]() {
-        // This thread can be used for additional processing if needed
-        // Currently, challan updates are handled in userPortalProcess and other processes
-        // Keeping it empty for now
-        while (running) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        }
-    });
+    sf::Text analyticsText;
+    analyticsText.setFont(font);
+    analyticsText.setCharacterSize(14);
+    analyticsText.setFillColor(sf::Color::White);
+    analyticsText.setPosition(10.f, 10.f);
 
     // Create SFML window
+    // Frames are paced by the scheduler, not the window
     sf::RenderWindow window(sf::VideoMode(800, 600), "SmartTraffix Simulation");
     sf::Sprite roadSprite(roadTexture);
     roadSprite.setScale(1.0f, 1.0f);
 
-    // Main loop
-    while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                performCleanup(pidChallanGenerator, pidStripePayment, pidUserPortal, -1);
-                window.close();
-            }
-        }
-
-        processQueues(); 
-        runDeadlockPrevention();
-        visualizeTraffic(window, roadSprite, font, analyticsText);
-    }
+    // Main loop; returns when the window is closed or SIGINT/SIGTERM clears `running`
+    runSimulation(window, roadSprite, analyticsText);
 
-    // Cleanup (in case window is closed without signal)
-    performCleanup(pidChallanGenerator, pidStripePayment, pidUserPortal, -1);
+    stopThreads();
+    performCleanup();
     return 0;
 }
 
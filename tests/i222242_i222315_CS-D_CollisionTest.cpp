@@ -0,0 +1,64 @@
+// CollisionTest.cpp
+// Swept contact: touching edges is not a collision, any overlap during the step is
+
+#include "Collision.h"
+#include "TestCheck.h"
+#include <cmath>
+
+static SweptBox box(float minX, float minY, float size, float dx = 0.f, float dy = 0.f) {
+    return {minX, minY, minX + size, minY + size, dx, dy};
+}
+
+static bool near(float a, float b) {
+    return std::fabs(a - b) < 1e-5f;
+}
+
+static void edgeContact() {
+    // Side by side and still, along either axis
+    CHECK(sweptBoxContact(box(0, 0, 10), box(10, 0, 10)) < 0.f);
+    CHECK(sweptBoxContact(box(0, 0, 10), box(0, 10, 10)) < 0.f);
+    // Corner to corner
+    CHECK(sweptBoxContact(box(0, 0, 10), box(10, 10, 10)) < 0.f);
+    // Sliding along a shared edge
+    CHECK(sweptBoxContact(box(0, 0, 10, 0, 25), box(10, 0, 10)) < 0.f);
+    // Closing the gap exactly by the end of the step, head on and diagonally
+    CHECK(sweptBoxContact(box(0, 0, 10, 10, 0), box(20, 0, 10)) < 0.f);
+    CHECK(sweptBoxContact(box(0, 0, 10, 10, 10), box(20, 20, 10)) < 0.f);
+    // Moving apart from touching
+    CHECK(sweptBoxContact(box(0, 0, 10, -5, 0), box(10, 0, 10)) < 0.f);
+}
+
+static void overlap() {
+    // Already overlapping collides at the start, even while separating
+    CHECK(near(sweptBoxContact(box(0, 0, 10), box(5, 5, 10)), 0.f));
+    CHECK(near(sweptBoxContact(box(0, 0, 10, -20, 0), box(5, 0, 10)), 0.f));
+    // Touching at the start and moving into each other
+    CHECK(near(sweptBoxContact(box(0, 0, 10, 5, 0), box(10, 0, 10)), 0.f));
+    // Meeting half way through the step
+    CHECK(near(sweptBoxContact(box(0, 0, 10, 20, 0), box(20, 0, 10)), 0.5f));
+    // Both moving, closing at their relative speed
+    CHECK(near(sweptBoxContact(box(0, 0, 10, 10, 0), box(30, 0, 10, -30, 0)), 0.5f));
+    // Fast enough to pass right through within one step
+    CHECK(near(sweptBoxContact(box(0, 0, 10, 100, 0), box(50, 0, 10)), 0.4f));
+    // Passing close by on a diagonal without ever overlapping
+    CHECK(sweptBoxContact(box(0, 0, 10, 30, 30), box(20, 0, 10)) < 0.f);
+}
+
+// The broadphase must keep the same edge-contact rule as the exact test
+static void broadphase() {
+    std::vector<SweptBox> boxes = {box(0, 0, 10), box(10, 0, 10), box(30, 0, 10, -15, 0), box(100, 100, 10)};
+    std::vector<CollisionPair> pairs;
+    findSweptCollisions(boxes, pairs);
+    CHECK(pairs.size() == 1);
+    if (pairs.size() == 1) {
+        CHECK(pairs[0].a == 1 && pairs[0].b == 2);
+        CHECK(near(pairs[0].time, 10.f / 15.f));
+    }
+}
+
+int main() {
+    edgeContact();
+    overlap();
+    broadphase();
+    return testResult("Collision");
+}
@@ -0,0 +1,107 @@
+// EventSchedulerTest.cpp
+// Calendar queue ordering while the bucket ring grows, shrinks and re-estimates its width
+
+#include "EventScheduler.h"
+#include "TestCheck.h"
+#include <queue>
+#include <random>
+#include <vector>
+
+// Reference order: earliest time first, ties in scheduling order
+struct LaterEvent {
+    bool operator()(const SimEvent &a, const SimEvent &b) const {
+        return a.time > b.time || (a.time == b.time && a.seq > b.seq);
+    }
+};
+typedef std::priority_queue<SimEvent, std::vector<SimEvent>, LaterEvent> ReferenceQueue;
+
+static bool sameEvent(const SimEvent &a, const SimEvent &b) {
+    return a.time == b.time && a.seq == b.seq;
+}
+
+// Pops everything left and checks it against the reference
+static void drainAndCompare(CalendarQueue &queue, ReferenceQueue &reference) {
+    while (!reference.empty()) {
+        CHECK(!queue.empty());
+        if (queue.empty()) return;
+        CHECK(sameEvent(queue.pop(), reference.top()));
+        reference.pop();
+    }
+    CHECK(queue.empty());
+}
+
+// Fills the queue past several doublings, then drains it past as many halvings
+static void growAndShrink() {
+    CalendarQueue queue;
+    ReferenceQueue reference;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> time(0.0, 1000.0);
+    unsigned long long seq = 0;
+    for (int i = 0; i < 5000; ++i) {
+        SimEvent event = {time(gen), seq++, 0, i};
+        queue.push(event);
+        reference.push(event);
+    }
+    CHECK(queue.size() == 5000);
+    drainAndCompare(queue, reference);
+}
+
+// Simultaneous events, far-future outliers and events before the scan position,
+// interleaved with pops so resizes happen with the scan part-way round the ring
+static void interleaved() {
+    CalendarQueue queue;
+    ReferenceQueue reference;
+    std::mt19937 gen(11);
+    std::exponential_distribution<double> gap(4.0);
+    std::uniform_int_distribution<int> kind(0, 9);
+    unsigned long long seq = 0;
+    double now = 0.0;
+
+    for (int round = 0; round < 20000; ++round) {
+        int pushes = round % 2000 < 1000 ? 2 : 0; // alternately fill and drain
+        for (int p = 0; p < pushes; ++p) {
+            double at;
+            switch (kind(gen)) {
+            case 0: at = now; break;                 // same time as the last pop
+            case 1: at = now + 1.0e5 * gap(gen); break; // far in the future
+            case 2: at = now * 0.5; break;           // before the scan position
+            default: at = now + gap(gen); break;
+            }
+            SimEvent event = {at, seq++, 0, round};
+            queue.push(event);
+            reference.push(event);
+        }
+        if (!reference.empty()) {
+            CHECK(!queue.empty());
+            if (queue.empty()) return;
+            SimEvent popped = queue.pop();
+            CHECK(sameEvent(popped, reference.top()));
+            reference.pop();
+            now = popped.time;
+        }
+        CHECK(queue.size() == reference.size());
+    }
+    drainAndCompare(queue, reference);
+}
+
+// The scheduler never goes back in time: an event scheduled in the past runs at now()
+static void schedulerClock() {
+    EventScheduler scheduler(false);
+    scheduler.schedule(5.0, 1);
+    scheduler.schedule(2.0, 2);
+    scheduler.schedule(2.0, 3);
+    SimEvent event;
+    CHECK(scheduler.next(event) && event.type == 2 && scheduler.now() == 2.0);
+    scheduler.schedule(1.0, 4);
+    CHECK(scheduler.next(event) && event.type == 3);
+    CHECK(scheduler.next(event) && event.type == 4 && scheduler.now() == 2.0);
+    CHECK(scheduler.next(event) && event.type == 1 && scheduler.now() == 5.0);
+    CHECK(!scheduler.next(event));
+}
+
+int main() {
+    growAndShrink();
+    interleaved();
+    schedulerClock();
+    return testResult("EventScheduler");
+}
@@ -0,0 +1,98 @@
+// SectionControlTest.cpp
+// Entry reads match their exit read inside the window and expire after it
+
+#include "SectionControl.h"
+#include "TestCheck.h"
+
+static const double WINDOW = 10.0;
+
+static void matchInsideWindow() {
+    SectionControl section(WINDOW);
+    section.addSection("North", 100.f);
+    SectionPassage passage;
+    section.entryRead("ABC-1", "North", 0.0);
+    CHECK(section.exitRead("ABC-1", "North", 5.0, passage));
+    CHECK(passage.plate == "ABC-1" && passage.section == "North");
+    CHECK(passage.entryTime == 0.0 && passage.exitTime == 5.0);
+    CHECK(passage.averageSpeed == 20.f);
+    // Matched entries leave the join state, so a second exit read finds nothing
+    CHECK(!section.exitRead("ABC-1", "North", 6.0, passage));
+    SectionControlStats stats = section.getStats();
+    CHECK(stats.matched == 1 && stats.unmatchedExits == 1 && stats.joinState == 0);
+}
+
+static void expiry() {
+    SectionControl section(WINDOW);
+    section.addSection("North", 100.f);
+    SectionPassage passage;
+
+    // An exit read past the window finds the entry already evicted
+    section.entryRead("ABC-2", "North", 1.0);
+    CHECK(!section.exitRead("ABC-2", "North", 12.0, passage));
+    // The window is closed at its end: an entry expires exactly WINDOW seconds later
+    section.entryRead("ABC-3", "North", 20.0);
+    CHECK(!section.exitRead("ABC-3", "North", 30.0, passage));
+    section.entryRead("ABC-4", "North", 40.0);
+    CHECK(section.exitRead("ABC-4", "North", 49.9, passage));
+    SectionControlStats stats = section.getStats();
+    CHECK(stats.evicted == 2 && stats.matched == 1 && stats.unmatchedExits == 2);
+
+    // evict() alone drops everything the window has passed
+    section.entryRead("ABC-5", "North", 60.0);
+    section.entryRead("ABC-6", "North", 65.0);
+    section.evict(70.0);
+    CHECK(section.getStats().joinState == 1);
+    section.evict(75.0);
+    stats = section.getStats();
+    CHECK(stats.joinState == 0 && stats.evicted == 4 && stats.peakJoinState == 2);
+}
+
+// A second entry read replaces the first; the first one's expiry must not evict it
+static void reentryKeepsLatestRead() {
+    SectionControl section(WINDOW);
+    section.addSection("North", 100.f);
+    SectionPassage passage;
+    section.entryRead("ABC-7", "North", 0.0);
+    section.entryRead("ABC-7", "North", 8.0);
+    section.evict(12.0);
+    CHECK(section.getStats().evicted == 0);
+    CHECK(section.exitRead("ABC-7", "North", 13.0, passage));
+    CHECK(passage.entryTime == 8.0);
+    // Both expiry records come due without evicting anything further
+    section.evict(30.0);
+    CHECK(section.getStats().evicted == 0);
+}
+
+static void keysAreSectionAndPlate() {
+    SectionControl section(WINDOW);
+    section.addSection("North", 100.f);
+    section.addSection("South", 50.f);
+    SectionPassage passage;
+    section.entryRead("ABC-8", "North", 0.0);
+    CHECK(!section.exitRead("ABC-8", "South", 2.0, passage));
+    CHECK(!section.exitRead("ABC-9", "North", 2.0, passage));
+    CHECK(section.exitRead("ABC-8", "North", 2.0, passage));
+    // Reads on a section that was never added are ignored
+    section.entryRead("ABC-8", "East", 3.0);
+    CHECK(!section.exitRead("ABC-8", "East", 4.0, passage));
+    CHECK(section.getStats().entryReads == 1);
+}
+
+// Plates longer than the key are cut; reads of the cut plate still pair up
+static void longPlates() {
+    SectionControl section(WINDOW);
+    section.addSection("North", 100.f);
+    SectionPassage passage;
+    std::string plate(SECTION_PLATE_CHARS + 8, 'X');
+    section.entryRead(plate, "North", 0.0);
+    CHECK(section.exitRead(plate, "North", 1.0, passage));
+}
+
+int main() {
+    matchInsideWindow();
+    expiry();
+    reentryKeepsLatestRead();
+    keysAreSectionAndPlate();
+    longPlates();
+    return testResult("SectionControl");
+}
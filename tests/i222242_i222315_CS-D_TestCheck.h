@@ -0,0 +1,29 @@
+// TestCheck.h
+
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <iostream>
+
+// Minimal checks for the module tests: a failed CHECK reports its line and the
+// test keeps going; main() returns testResult() so `make test` stops on failure.
+static int testFailures = 0;
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition << std::endl; \
+            testFailures++;                                                                \
+        }                                                                                  \
+    } while (0)
+
+inline int testResult(const char *name) {
+    if (testFailures > 0) {
+        std::cerr << "[" << name << "] " << testFailures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "[" << name << "] passed" << std::endl;
+    return 0;
+}
+
+#endif // TEST_CHECK_H